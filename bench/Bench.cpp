@@ -0,0 +1,338 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <regex>
+#include <sstream>
+
+
+namespace {
+  /**
+   * Clock used for every measurement
+   *
+   */
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Time the given number of operations of the given body
+   *
+   * @param body  Function performing the given number of operations
+   * @param n     Number of operations to perform
+   * @return the elapsed time
+   */
+  std::chrono::nanoseconds timeIt(std::function<void(std::size_t)> const &body, std::size_t n) {
+    Clock::time_point start = Clock::now();
+    body(n);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+  }
+
+  /**
+   * Build an empty counter reading
+   *
+   * @return a reading with every event unavailable
+   */
+  PerfCounters::Reading noReading() noexcept {
+    PerfCounters::Reading ret;
+    ret.value.fill(0.0);
+    ret.valid.fill(false);
+    return ret;
+  }
+
+  /**
+   * Format the given counts per operation as a human-readable summary
+   *
+   * Cycles are given per bit when the number of bits per operation is
+   * known, and per operation otherwise.
+   *
+   * @param perf       Counts per operation
+   * @param bitsPerOp  Bits processed per operation (0 if not meaningful)
+   * @return the formatted summary
+   */
+  std::string perfSummary(PerfCounters::Reading const &perf, double bitsPerOp) {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2);
+    if (perf.valid[PerfCounters::cycles]) {
+      if (0 < bitsPerOp) {
+        os << "  cycles/bit " << perf.value[PerfCounters::cycles] / bitsPerOp;
+      } else {
+        os << "  cycles/op " << perf.value[PerfCounters::cycles];
+      }
+      if (perf.valid[PerfCounters::instructions] && 0 < perf.value[PerfCounters::cycles]) {
+        os << "  IPC " << perf.value[PerfCounters::instructions] / perf.value[PerfCounters::cycles];
+      }
+    }
+    for (PerfCounters::Event e : {PerfCounters::branchMisses, PerfCounters::l1dMisses, PerfCounters::llcMisses}) {
+      if (perf.valid[e]) { os << "  " << PerfCounters::name(e) << "/op " << perf.value[e]; }
+    }
+    return os.str();
+  }
+
+  /**
+   * Escape the given string for inclusion in a JSON string literal
+   *
+   * @param s  String to escape
+   * @return the escaped string
+   */
+  std::string jsonEscape(std::string const &s) {
+    std::string ret;
+    for (char c : s) {
+      if ('"' == c || '\\' == c) { ret += '\\'; }
+      ret += c;
+    }
+    return ret;
+  }
+
+  /**
+   * Format the given throughput in bits per second with a binary-free SI prefix
+   *
+   * @param bps  Throughput to format
+   * @return the formatted throughput
+   */
+  std::string siBits(double bps) {
+    static char const *const prefixes[] = {"", "k", "M", "G", "T"};
+    std::size_t i = 0;
+    while (1000.0 <= bps && i + 1 < sizeof(prefixes) / sizeof(prefixes[0])) { bps /= 1000.0; i++; }
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2) << bps << ' ' << prefixes[i] << "bit/s";
+    return os.str();
+  }
+}
+
+
+/**
+ * Construct a harness with the given sampling parameters
+ *
+ * @param minS    Minimum number of samples to take per case
+ * @param maxS    Maximum number of samples to take per case
+ * @param sample  Target duration of a single sample
+ * @param budget  Time budget per case (once the minimum number of samples has been taken)
+ */
+Bench::Bench(std::size_t minS, std::size_t maxS, std::chrono::nanoseconds sample, std::chrono::nanoseconds budget) noexcept
+: minSamples(std::max<std::size_t>(1, minS)), maxSamples(std::max(minS, maxS)), sampleTime(sample), caseTime(budget), patterns(), pmu(), cases(), results() {}
+
+/**
+ * Restrict the cases to run to those whose names contain any of the given patterns
+ *
+ * @param pats  Substrings to look for (an empty list runs every case)
+ * @return the current harness
+ */
+Bench &Bench::filter(std::vector<std::string> const &pats) {
+  patterns = pats;
+  return *this;
+}
+
+/**
+ * Enable or disable hardware performance counter collection
+ *
+ * Counters that are not available are silently left out.
+ *
+ * @param enable  Whether to collect counters
+ * @return the current harness
+ */
+Bench &Bench::counters(bool enable) {
+  pmu.reset(enable ? new PerfCounters() : nullptr);
+  return *this;
+}
+
+/**
+ * Register a benchmark case
+ *
+ * @param name       Case name
+ * @param bitsPerOp  Bits processed per operation (0 if not meaningful)
+ * @param body       Function performing the given number of operations
+ * @return the current harness
+ */
+Bench &Bench::add(std::string const &name, double bitsPerOp, std::function<void(std::size_t)> const &body) {
+  cases.push_back({name, bitsPerOp, body});
+  return *this;
+}
+
+/**
+ * Run every selected case, reporting each result as it becomes available
+ *
+ * @param os  Stream to report progress to
+ * @return the results, in registration order
+ */
+std::vector<Bench::Result> const &Bench::run(std::ostream &os) {
+  results.clear();
+
+  if (pmu && !pmu->available()) {
+    os << "Hardware counters unavailable (" << pmu->error() << "), reporting wall-clock times only" << std::endl << std::endl;
+  }
+
+  os << std::left << std::setw(40) << "case" << std::right
+     << std::setw(14) << "min ns/op" << std::setw(14) << "median ns/op" << std::setw(14) << "p99 ns/op"
+     << std::setw(18) << "median bits/s" << std::endl;
+
+  for (Case const &c : cases) {
+    if (!selected(c.name)) { continue; }
+    Result r = measure(c);
+    os << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(1)
+       << std::setw(14) << r.minNs << std::setw(14) << r.medianNs << std::setw(14) << r.p99Ns
+       << std::setw(18) << (0 < r.bitsPerOp ? siBits(r.bitsPerOp * 1e9 / r.medianNs) : std::string("-")) << std::endl;
+    if (pmu && pmu->available()) {
+      os << "   " << perfSummary(r.perf, r.bitsPerOp) << std::endl;
+    }
+    results.push_back(r);
+  }
+
+  return results;
+}
+
+/**
+ * Write the given results as JSON
+ *
+ * Each result is written on a line of its own, so that readJson() needs
+ * no general-purpose JSON parser.
+ *
+ * @param os  Stream to write to
+ * @param rs  Results to write
+ */
+void Bench::writeJson(std::ostream &os, std::vector<Result> const &rs) {
+  os << "{\"results\": [" << std::endl;
+  for (std::size_t i = 0; i < rs.size(); i++) {
+    Result const &r = rs[i];
+    os << "  {\"name\": \"" << jsonEscape(r.name) << "\""
+       << ", \"bits_per_op\": " << r.bitsPerOp
+       << ", \"iterations\": " << r.iterations
+       << ", \"samples\": " << r.samples
+       << std::setprecision(6) << std::fixed
+       << ", \"min_ns\": " << r.minNs
+       << ", \"median_ns\": " << r.medianNs
+       << ", \"p99_ns\": " << r.p99Ns
+       << std::defaultfloat
+       << ", \"bits_per_s\": " << (0 < r.bitsPerOp ? r.bitsPerOp * 1e9 / r.medianNs : 0.0);
+    for (std::size_t e = 0; e < PerfCounters::events; e++) {
+      if (r.perf.valid[e]) { os << ", \"" << PerfCounters::name(static_cast<PerfCounters::Event>(e)) << "_per_op\": " << r.perf.value[e]; }
+    }
+    if (r.perf.valid[PerfCounters::cycles] && 0 < r.bitsPerOp) {
+      os << ", \"cycles_per_bit\": " << r.perf.value[PerfCounters::cycles] / r.bitsPerOp;
+    }
+    if (r.perf.valid[PerfCounters::cycles] && r.perf.valid[PerfCounters::instructions] && 0 < r.perf.value[PerfCounters::cycles]) {
+      os << ", \"ipc\": " << r.perf.value[PerfCounters::instructions] / r.perf.value[PerfCounters::cycles];
+    }
+    os << "}" << (i + 1 < rs.size() ? "," : "") << std::endl;
+  }
+  os << "]}" << std::endl;
+}
+
+/**
+ * Read results previously written by writeJson()
+ *
+ * @param is  Stream to read from
+ * @return the results read
+ */
+std::vector<Bench::Result> Bench::readJson(std::istream &is) {
+  static std::regex const line("\"name\": \"((?:[^\"\\\\]|\\\\.)*)\", \"bits_per_op\": ([^,]+), \"iterations\": ([^,]+), \"samples\": ([^,]+), \"min_ns\": ([^,]+), \"median_ns\": ([^,]+), \"p99_ns\": ([^,]+),");
+  static std::regex const unescape("\\\\(.)");
+
+  std::vector<Result> ret;
+  std::string s;
+  std::smatch m;
+  while (std::getline(is, s)) {
+    if (std::regex_search(s, m, line)) {
+      ret.push_back({
+        std::regex_replace(m[1].str(), unescape, "$1"),
+        std::stod(m[2].str()),
+        std::stoul(m[3].str()),
+        std::stoul(m[4].str()),
+        std::stod(m[5].str()),
+        std::stod(m[6].str()),
+        std::stod(m[7].str()),
+        noReading(),
+      });
+    }
+  }
+  return ret;
+}
+
+/**
+ * Compare the given results against a baseline, reporting regressions
+ *
+ * A case regresses if its median time per operation exceeds the
+ * baseline's by more than the given fraction; cases missing from either
+ * side are ignored.
+ *
+ * @param os         Stream to report to
+ * @param rs         Results to check
+ * @param baseline   Baseline results
+ * @param threshold  Allowed slowdown, as a fraction of the baseline median
+ * @return the number of regressions found
+ */
+std::size_t Bench::compare(std::ostream &os, std::vector<Result> const &rs, std::vector<Result> const &baseline, double threshold) {
+  std::map<std::string, double> base;
+  for (Result const &r : baseline) { base[r.name] = r.medianNs; }
+
+  std::size_t regressions = 0;
+  os << std::left << std::setw(40) << "case" << std::right << std::setw(14) << "baseline ns" << std::setw(14) << "current ns" << std::setw(10) << "change" << std::endl;
+  for (Result const &r : rs) {
+    auto it = base.find(r.name);
+    if (base.end() == it || !(0 < it->second)) { continue; }
+    double change = r.medianNs / it->second - 1.0;
+    bool regressed = threshold < change;
+    regressions += regressed;
+    os << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(1)
+       << std::setw(14) << it->second << std::setw(14) << r.medianNs
+       << std::setw(9) << std::showpos << 100.0 * change << std::noshowpos << '%'
+       << (regressed ? "  REGRESSION" : "") << std::endl;
+  }
+  return regressions;
+}
+
+/**
+ * Determine whether the given case name is selected by the current filter
+ *
+ * @param name  Case name to check
+ * @return true if the case should be run, false otherwise
+ */
+bool Bench::selected(std::string const &name) const noexcept {
+  if (patterns.empty()) { return true; }
+  for (std::string const &p : patterns) {
+    if (std::string::npos != name.find(p)) { return true; }
+  }
+  return false;
+}
+
+/**
+ * Run a single case
+ *
+ * @param c  Case to run
+ * @return the case's result
+ */
+Bench::Result Bench::measure(Case const &c) const {
+  // warm up, then calibrate the number of operations per sample
+  std::size_t n = 1;
+  std::chrono::nanoseconds t = timeIt(c.body, n);
+  for (std::size_t round = 0; round < 2 && t < sampleTime; round++) {
+    double scale = 0 < t.count() ? static_cast<double>(sampleTime.count()) / static_cast<double>(t.count()) : 1000.0;
+    n = std::max<std::size_t>(n + 1, static_cast<std::size_t>(static_cast<double>(n) * std::min(scale, 1000.0)));
+    t = timeIt(c.body, n);
+  }
+
+  // sample until both the minimum number of samples and the time budget are exhausted, accumulating counts if enabled
+  std::vector<double> ns;
+  PerfCounters::Reading perf = noReading();
+  if (pmu) { perf.valid.fill(true); }
+  Clock::time_point start = Clock::now();
+  while (ns.size() < minSamples || (ns.size() < maxSamples && Clock::now() - start < caseTime)) {
+    if (pmu) { pmu->start(); }
+    ns.push_back(static_cast<double>(timeIt(c.body, n).count()) / static_cast<double>(n));
+    if (pmu) {
+      PerfCounters::Reading r = pmu->stop();
+      for (std::size_t e = 0; e < PerfCounters::events; e++) { perf.value[e] += r.value[e]; perf.valid[e] = perf.valid[e] && r.valid[e]; }
+    }
+  }
+  for (double &v : perf.value) { v /= static_cast<double>(n * ns.size()); }
+
+  // order statistics (p99 by nearest rank)
+  std::sort(ns.begin(), ns.end());
+  std::size_t k = ns.size();
+  double median = k % 2 ? ns[k / 2] : (ns[k / 2 - 1] + ns[k / 2]) / 2.0;
+  double p99 = ns[static_cast<std::size_t>(std::ceil(0.99 * static_cast<double>(k))) - 1];
+
+  return {c.name, c.bitsPerOp, n, k, ns.front(), median, p99, perf};
+}
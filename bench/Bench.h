@@ -0,0 +1,270 @@
+#ifndef BENCH_H__
+#define BENCH_H__
+
+#include <cstddef>
+#include <chrono>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PerfCounters.h"
+
+
+/**
+ * Micro-benchmark harness
+ *
+ * Cases are registered as a name, a number of bits processed per operation
+ * (0 if not meaningful), and a body performing a given number of
+ * operations.
+ *
+ * Each case is warmed up and calibrated so that a single sample takes
+ * roughly the configured sample time, then sampled repeatedly (at least
+ * the configured minimum number of times, and until either the maximum
+ * number of samples or the per-case time budget is reached); the minimum,
+ * median, and 99th percentile time per operation are reported.
+ *
+ * Optionally, hardware performance counters are collected over every
+ * sample and reported per operation.
+ *
+ */
+class Bench {
+  public:
+    /**
+     * Result of a single benchmark case
+     *
+     */
+    struct Result {
+      /**
+       * Case name
+       *
+       */
+      std::string name;
+
+      /**
+       * Bits processed per operation (0 if not meaningful)
+       *
+       */
+      double bitsPerOp;
+
+      /**
+       * Operations per sample
+       *
+       */
+      std::size_t iterations;
+
+      /**
+       * Number of samples taken
+       *
+       */
+      std::size_t samples;
+
+      /**
+       * Minimum time per operation, in nanoseconds
+       *
+       */
+      double minNs;
+
+      /**
+       * Median time per operation, in nanoseconds
+       *
+       */
+      double medianNs;
+
+      /**
+       * 99th percentile time per operation, in nanoseconds
+       *
+       */
+      double p99Ns;
+
+      /**
+       * Hardware counts per operation, if collected
+       *
+       */
+      PerfCounters::Reading perf;
+    };
+
+    /**
+     * Construct a harness with the given sampling parameters
+     *
+     * @param minS    Minimum number of samples to take per case
+     * @param maxS    Maximum number of samples to take per case
+     * @param sample  Target duration of a single sample
+     * @param budget  Time budget per case (once the minimum number of samples has been taken)
+     */
+    Bench(std::size_t minS, std::size_t maxS, std::chrono::nanoseconds sample, std::chrono::nanoseconds budget) noexcept;
+
+    /**
+     * Restrict the cases to run to those whose names contain any of the given patterns
+     *
+     * @param pats  Substrings to look for (an empty list runs every case)
+     * @return the current harness
+     */
+    Bench &filter(std::vector<std::string> const &pats);
+
+    /**
+     * Enable or disable hardware performance counter collection
+     *
+     * Counters that are not available are silently left out.
+     *
+     * @param enable  Whether to collect counters
+     * @return the current harness
+     */
+    Bench &counters(bool enable);
+
+    /**
+     * Register a benchmark case
+     *
+     * @param name       Case name
+     * @param bitsPerOp  Bits processed per operation (0 if not meaningful)
+     * @param body       Function performing the given number of operations
+     * @return the current harness
+     */
+    Bench &add(std::string const &name, double bitsPerOp, std::function<void(std::size_t)> const &body);
+
+    /**
+     * Run every selected case, reporting each result as it becomes available
+     *
+     * @param os  Stream to report progress to
+     * @return the results, in registration order
+     */
+    std::vector<Result> const &run(std::ostream &os);
+
+    /**
+     * Write the given results as JSON
+     *
+     * Each result is written on a line of its own, so that readJson() needs
+     * no general-purpose JSON parser.
+     *
+     * @param os  Stream to write to
+     * @param rs  Results to write
+     */
+    static void writeJson(std::ostream &os, std::vector<Result> const &rs);
+
+    /**
+     * Read results previously written by writeJson()
+     *
+     * @param is  Stream to read from
+     * @return the results read
+     */
+    static std::vector<Result> readJson(std::istream &is);
+
+    /**
+     * Compare the given results against a baseline, reporting regressions
+     *
+     * A case regresses if its median time per operation exceeds the
+     * baseline's by more than the given fraction; cases missing from either
+     * side are ignored.
+     *
+     * @param os         Stream to report to
+     * @param rs         Results to check
+     * @param baseline   Baseline results
+     * @param threshold  Allowed slowdown, as a fraction of the baseline median
+     * @return the number of regressions found
+     */
+    static std::size_t compare(std::ostream &os, std::vector<Result> const &rs, std::vector<Result> const &baseline, double threshold);
+
+  protected:
+    /**
+     * Registered benchmark case
+     *
+     */
+    struct Case {
+      /**
+       * Case name
+       *
+       */
+      std::string name;
+
+      /**
+       * Bits processed per operation (0 if not meaningful)
+       *
+       */
+      double bitsPerOp;
+
+      /**
+       * Function performing the given number of operations
+       *
+       */
+      std::function<void(std::size_t)> body;
+    };
+
+    /**
+     * Determine whether the given case name is selected by the current filter
+     *
+     * @param name  Case name to check
+     * @return true if the case should be run, false otherwise
+     */
+    bool selected(std::string const &name) const noexcept;
+
+    /**
+     * Run a single case
+     *
+     * @param c  Case to run
+     * @return the case's result
+     */
+    Result measure(Case const &c) const;
+
+    /**
+     * Minimum number of samples to take per case
+     *
+     */
+    std::size_t minSamples;
+
+    /**
+     * Maximum number of samples to take per case
+     *
+     */
+    std::size_t maxSamples;
+
+    /**
+     * Target duration of a single sample
+     *
+     */
+    std::chrono::nanoseconds sampleTime;
+
+    /**
+     * Time budget per case
+     *
+     */
+    std::chrono::nanoseconds caseTime;
+
+    /**
+     * Name patterns to select cases by
+     *
+     */
+    std::vector<std::string> patterns;
+
+    /**
+     * Hardware performance counters, if enabled
+     *
+     */
+    std::unique_ptr<PerfCounters> pmu;
+
+    /**
+     * Registered cases
+     *
+     */
+    std::vector<Case> cases;
+
+    /**
+     * Results of the last run
+     *
+     */
+    std::vector<Result> results;
+};
+
+
+/**
+ * Prevent the compiler from optimizing away the computation of the given value
+ *
+ * @param v  Value to keep
+ */
+template <typename T>
+inline void keep(T const &v) noexcept {
+  asm volatile("" : : "r"(&v) : "memory");
+}
+
+
+#endif  /* BENCH_H__ */
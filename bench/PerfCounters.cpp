@@ -0,0 +1,164 @@
+#include "PerfCounters.h"
+
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+#ifdef __linux__
+  /**
+   * Open a counter for the given event on the calling thread
+   *
+   * @param type    Event type
+   * @param config  Event configuration
+   * @return the counter's file descriptor, or -1 on error (errno is set)
+   */
+  int openCounter(std::uint32_t type, std::uint64_t config) noexcept {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  /**
+   * Build a hardware cache event configuration for read misses on the given cache
+   *
+   * @param cache  Cache identifier
+   * @return the event configuration
+   */
+  constexpr std::uint64_t cacheReadMisses(std::uint64_t cache) noexcept {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+#endif
+}
+
+
+/**
+ * Open every counter that can be opened
+ *
+ */
+PerfCounters::PerfCounters() noexcept : fds(), why() {
+  fds.fill(-1);
+#ifdef __linux__
+  std::array<std::pair<std::uint32_t, std::uint64_t>, events> const which = {{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, cacheReadMisses(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, cacheReadMisses(PERF_COUNT_HW_CACHE_LL)},
+  }};
+  for (std::size_t i = 0; i < events; i++) {
+    fds[i] = openCounter(which[i].first, which[i].second);
+    if (fds[i] < 0 && why.empty()) {
+      why = std::string("perf_event_open: ") + std::strerror(errno);
+    }
+  }
+#else
+  why = "hardware counters are only supported on Linux";
+#endif
+}
+
+/**
+ * Destructor, closes every open counter
+ *
+ */
+PerfCounters::~PerfCounters() noexcept {
+#ifdef __linux__
+  for (int fd : fds) {
+    if (0 <= fd) { close(fd); }
+  }
+#endif
+}
+
+/**
+ * Determine whether any counter could be opened
+ *
+ * @return true if at least one counter is available, false otherwise
+ */
+bool PerfCounters::available() const noexcept {
+  for (int fd : fds) {
+    if (0 <= fd) { return true; }
+  }
+  return false;
+}
+
+/**
+ * Describe why counters are unavailable
+ *
+ * @return the error the first counter failed with, or the empty string if none failed
+ */
+std::string const &PerfCounters::error() const noexcept {
+  return why;
+}
+
+/**
+ * Reset and start every available counter
+ *
+ */
+void PerfCounters::start() noexcept {
+#ifdef __linux__
+  for (int fd : fds) {
+    if (0 <= fd) { ioctl(fd, PERF_EVENT_IOC_RESET, 0); }
+  }
+  for (int fd : fds) {
+    if (0 <= fd) { ioctl(fd, PERF_EVENT_IOC_ENABLE, 0); }
+  }
+#endif
+}
+
+/**
+ * Stop every available counter and read it
+ *
+ * @return the counts since the last call to start()
+ */
+PerfCounters::Reading PerfCounters::stop() noexcept {
+  Reading ret;
+  ret.value.fill(0.0);
+  ret.valid.fill(false);
+#ifdef __linux__
+  for (int fd : fds) {
+    if (0 <= fd) { ioctl(fd, PERF_EVENT_IOC_DISABLE, 0); }
+  }
+  for (std::size_t i = 0; i < events; i++) {
+    // value, time enabled, time running
+    std::uint64_t buf[3];
+    if (fds[i] < 0 || sizeof(buf) != static_cast<std::size_t>(read(fds[i], buf, sizeof(buf))) || 0 == buf[2]) { continue; }
+    // scale up to compensate for multiplexing
+    ret.value[i] = static_cast<double>(buf[0]) * (static_cast<double>(buf[1]) / static_cast<double>(buf[2]));
+    ret.valid[i] = true;
+  }
+#endif
+  return ret;
+}
+
+/**
+ * Get the given event's short name
+ *
+ * @param e  Event to get the name of
+ * @return the event's name
+ */
+char const *PerfCounters::name(Event e) noexcept {
+  switch (e) {
+    case cycles:       return "cycles";
+    case instructions: return "instructions";
+    case branchMisses: return "branch_misses";
+    case l1dMisses:    return "l1d_misses";
+    case llcMisses:    return "llc_misses";
+    default:           return "unknown";
+  }
+}
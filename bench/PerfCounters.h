@@ -0,0 +1,134 @@
+#ifndef PERF_COUNTERS_H__
+#define PERF_COUNTERS_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <string>
+
+
+/**
+ * Hardware performance counters for the calling thread
+ *
+ * On Linux, this class opens one perf_event_open(2) counter per event,
+ * counting user-space activity of the calling thread only; events that
+ * cannot be opened (eg. inside containers, under a restrictive
+ * perf_event_paranoid setting, or on virtualized hardware lacking a PMU)
+ * are simply reported as unavailable, as is every event elsewhere.
+ *
+ * Counts are scaled to compensate for counter multiplexing.
+ *
+ */
+class PerfCounters {
+  public:
+    /**
+     * Events counted
+     *
+     */
+    enum Event : std::size_t {
+      cycles,
+      instructions,
+      branchMisses,
+      l1dMisses,
+      llcMisses,
+    };
+
+    /**
+     * Number of events counted
+     *
+     */
+    static constexpr std::size_t events = 5;
+
+    /**
+     * Counter reading, with a validity flag per event
+     *
+     */
+    struct Reading {
+      /**
+       * Counted values
+       *
+       */
+      std::array<double, events> value;
+
+      /**
+       * Whether each value is available
+       *
+       */
+      std::array<bool, events> valid;
+    };
+
+    /**
+     * Open every counter that can be opened
+     *
+     */
+    PerfCounters() noexcept;
+
+    /**
+     * Deleted copy constructor
+     *
+     */
+    PerfCounters(PerfCounters const &) = delete;
+
+    /**
+     * Deleted copy assignment
+     *
+     */
+    PerfCounters &operator=(PerfCounters const &) = delete;
+
+    /**
+     * Destructor, closes every open counter
+     *
+     */
+    ~PerfCounters() noexcept;
+
+    /**
+     * Determine whether any counter could be opened
+     *
+     * @return true if at least one counter is available, false otherwise
+     */
+    bool available() const noexcept __attribute__((pure));
+
+    /**
+     * Describe why counters are unavailable
+     *
+     * @return the error the first counter failed with, or the empty string if none failed
+     */
+    std::string const &error() const noexcept __attribute__((const));
+
+    /**
+     * Reset and start every available counter
+     *
+     */
+    void start() noexcept;
+
+    /**
+     * Stop every available counter and read it
+     *
+     * @return the counts since the last call to start()
+     */
+    Reading stop() noexcept;
+
+    /**
+     * Get the given event's short name
+     *
+     * @param e  Event to get the name of
+     * @return the event's name
+     */
+    static char const *name(Event e) noexcept __attribute__((const));
+
+  protected:
+    /**
+     * Counter file descriptors (-1 for unavailable counters)
+     *
+     */
+    std::array<int, events> fds;
+
+    /**
+     * Error the first unavailable counter failed with
+     *
+     */
+    std::string why;
+};
+
+
+#endif  /* PERF_COUNTERS_H__ */
@@ -0,0 +1,489 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Bench.h"
+
+#include "BitEngine.h"
+#include "BitReservoir.h"
+#include "DynSub.h"
+#include "DynSubStream.h"
+#include "DynTrans.h"
+#include "HashBatch.h"
+#include "Icg.h"
+#include "Lfsr.h"
+#include "Random.h"
+#include "StreamMonitor.h"
+#include "ThreadPool.h"
+#include "Xsg.h"
+#include "XsgLanes.h"
+
+
+namespace {
+  /**
+   * Key every benchmarked generator is distilled from
+   *
+   */
+  constexpr char const *benchKey = "yggdrasill benchmark key";
+
+  /**
+   * Build a message of the given length with varied contents
+   *
+   * @param len   Message length
+   * @param salt  Value to vary the contents by
+   * @return the message built
+   */
+  std::string message(std::size_t len, std::size_t salt = 0) {
+    std::string ret(len, '\0');
+    for (std::size_t i = 0; i < len; i++) { ret[i] = static_cast<char>((i * 131 + salt * 17) & 0xff); }
+    return ret;
+  }
+
+  /**
+   * Pair of permutations to invert and compose
+   *
+   */
+  using PermutationPair = std::pair<Permutation<std::uint32_t>, Permutation<std::uint32_t>>;
+
+  /**
+   * Shuffle the given pair of permutations to the given size, unless already done
+   *
+   * The contents of a permutation do not affect the time taken to invert or
+   * compose it, so these are shuffled by a cheap seeded PRNG when a selected
+   * case first runs, instead of being drawn from Xsg at registration.
+   *
+   * @param pq   Permutations to shuffle
+   * @param len  Size of each permutation
+   * @return the shuffled permutations
+   */
+  PermutationPair const &shuffled(PermutationPair &pq, std::size_t len) {
+    if (len != pq.first.size()) {
+      std::mt19937_64 prng(len);
+      pq.first = Permutation<std::uint32_t>(len);
+      pq.second = Permutation<std::uint32_t>(len);
+      std::shuffle(pq.first.data(), pq.first.data() + len, prng);
+      std::shuffle(pq.second.data(), pq.second.data() + len, prng);
+    }
+    return pq;
+  }
+
+  /**
+   * Register an LFSR stepping case for the given register size
+   *
+   * @param N  LFSR register size
+   * @param b    Harness to register into
+   * @param gen  Generator polynomial, in hexadecimal
+   */
+  template <std::size_t N>
+  void addLfsr(Bench &b, std::string const &gen) {
+    Lfsr<N> l(std::string("1"), gen);
+    b.add("lfsr/step/" + std::to_string(N), 1, [l](std::size_t n) mutable {
+      for (std::size_t i = 0; i < n; i++) { keep(l.next()); }
+    });
+  }
+
+  /**
+   * Register the primitive generators' cases
+   *
+   * @param b  Harness to register into
+   * @param g  Keyed generator to use
+   */
+  void addPrimitives(Bench &b, Xsg512 const &g) {
+    addLfsr<521>(b, "1986842c7f1620218c78e583637aa0baf82558ef35d875948b22ce317ba47cce076f48541f1a593896ee3f9e3c9541b4d3e65941170c721e4d5c879a51bff933e1f");
+    addLfsr<523>(b, "6105ba99822ea4b0b57c26d5aa74c6b17f150b4c33147b4bd570e9aa1cbc663291ef6185805aa700b61672751f068eda9a1698c62b3fe4e7b034f3b8d899dfcfd92");
+    addLfsr<541>(b, "1ec09c4098c55499ac20b3925f4297c214e193d3dae3cea7f18afc422f315b82967b4b0f2c6bb5c4ae568ce242144d568731dbfeeb91d60ba4af6380a7428e7567c7e2df");
+    addLfsr<547>(b, "64f78024e326cc0d2dff541adc8737fc1843235fdb1feade3971cb90a49a8d2e1327babeaba4323e7481208590446fc35f9b2aa49a3a945b19e0a511148fbca3693f7a62b");
+    addLfsr<557>(b, "16e4b48a1c95a2964c7e25d6d874610f3c8b062e65c3612a0159ff1db7cc37ca400b419d54f6862d9c9e99cea9c7c631d58c2d4b1fb3898ca473ad780d5cb815897e4c2fdffc");
+
+    Icg icg(541, 31, 9, 1);
+    b.add("icg/next", 0, [icg](std::size_t n) mutable {
+      for (std::size_t i = 0; i < n; i++) { keep(icg.next()); }
+    });
+
+    b.add("xsg512/next", 1, [x = g](std::size_t n) mutable {
+      for (std::size_t i = 0; i < n; i++) { keep(x.next()); }
+    });
+
+    // standard library integration, through the buffered engine
+    b.add("bitEngine/xsg512", 64, [x = g](std::size_t n) mutable {
+      BitEngine e(x);
+      for (std::size_t i = 0; i < n; i++) { keep(e()); }
+    });
+    b.add("std::shuffle/bitEngine/xsg512/4096", 0, [x = g](std::size_t n) mutable {
+      BitEngine e(x);
+      std::vector<std::uint32_t> v(4096);
+      for (std::size_t i = 0; i < v.size(); i++) { v[i] = static_cast<std::uint32_t>(i); }
+      for (std::size_t i = 0; i < n; i++) { std::shuffle(v.begin(), v.end(), e); keep(v); }
+    });
+  }
+
+  /**
+   * Register the hashing cases
+   *
+   * @param b  Harness to register into
+   * @param g  Keyed generator to use
+   */
+  void addHashing(Bench &b, Xsg512 const &g) {
+    for (std::size_t len : {std::size_t(16), std::size_t(1) << 10, std::size_t(1) << 20}) {
+      std::string msg = message(len);
+      b.add("xsg512/hash/" + std::to_string(len) + "B", 8.0 * static_cast<double>(len), [x = g, msg](std::size_t n) mutable {
+        char out[32];
+        for (std::size_t i = 0; i < n; i++) { x.reset(); x.hash(msg, 128, out); keep(out); }
+      });
+    }
+
+    // multi-lane hashing of equal-length messages
+    std::shared_ptr<std::vector<std::string>> msgs = std::make_shared<std::vector<std::string>>();
+    for (std::size_t i = 0; i < 64; i++) { msgs->push_back(message(1024, i)); }
+    std::shared_ptr<Xsg512Lanes<64>> lanes = std::make_shared<Xsg512Lanes<64>>(g);
+    b.add("xsg512lanes64/hash/1024B", 64.0 * 8.0 * 1024.0, [lanes, msgs](std::size_t n) {
+      std::vector<char> out(64 * 32);
+      for (std::size_t i = 0; i < n; i++) { lanes->hash(msgs->data(), 128, out.data()); keep(out); }
+    });
+
+    // batch hashing scaling, from a single core up to every available one
+    std::size_t hw = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    for (std::size_t t = 1; t <= hw; t = (t == hw ? hw + 1 : std::min(2 * t, hw))) {
+      std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(t);
+      b.add("hashBatch/64x1024B/threads/" + std::to_string(t), 64.0 * 8.0 * 1024.0, [g, msgs, pool](std::size_t n) {
+        std::vector<char> out(64 * 32);
+        for (std::size_t i = 0; i < n; i++) { hashBatch(g, *msgs, 128, out.data(), *pool); keep(out); }
+      });
+    }
+
+    b.add("distillXsg", 0, [](std::size_t n) {
+      for (std::size_t i = 0; i < n; i++) { keep(distillXsg(benchKey)); }
+    });
+  }
+
+  /**
+   * Register a dynamic substitution case for the given substitution type
+   *
+   * @param S     Dynamic substitution class
+   * @param b     Harness to register into
+   * @param name  Case name
+   * @param g     Keyed generator to use
+   */
+  template <typename S>
+  void addDynSub(Bench &b, std::string const &name, Xsg512 const &g) {
+    std::shared_ptr<S> sub = std::make_shared<S>(g);
+    b.add("dynsub/" + name + "/xfrm/4096B", 8.0 * 4096.0, [sub](std::size_t n) {
+      std::vector<std::uint8_t> block(4096);
+      for (std::size_t i = 0; i < n; i++) {
+        for (std::uint8_t &c : block) { c = sub->xfrm(c); }
+        keep(block);
+      }
+    });
+  }
+
+  /**
+   * Register block-level dynamic substitution cases for the given substitution type
+   *
+   * Blocks are 16 bytes wide; the "virtual" case transforms each byte
+   * through a virtual call on a separately allocated lane (as the block
+   * level used to), the "xfrmBlocks" case goes through the type selected
+   * at construction.
+   *
+   * @param S     Dynamic Substitution class
+   * @param b     Harness to register into
+   * @param name  Case name
+   * @param type  Dynamic Substitution type
+   * @param g     Keyed generator to use
+   */
+  template <typename S>
+  void addDynSubBlocks(Bench &b, std::string const &name, DynSubType type, Xsg512 const &g) {
+    Xsg512 x = g;
+    std::vector<value_ptr<BitGenerator>> gens;
+    for (std::size_t i = 0; i < 16; i++) { x.nextBits(64); gens.emplace_back(new Xsg512(x)); }
+
+    std::shared_ptr<std::vector<value_ptr<DynSubSRSD>>> lanes = std::make_shared<std::vector<value_ptr<DynSubSRSD>>>();
+    for (value_ptr<BitGenerator> const &gen : gens) { lanes->emplace_back(new S(*gen)); }
+    b.add("dynsub/block16/" + name + "/virtual/4096B", 8.0 * 4096.0, [lanes](std::size_t n) {
+      std::vector<std::uint8_t> data(4096);
+      for (std::size_t i = 0; i < n; i++) {
+        for (std::size_t j = 0; j < data.size(); j++) { data[j] = (*lanes)[j % 16]->xfrm(data[j]); }
+        keep(data);
+      }
+    });
+
+    std::shared_ptr<DynSub> sub = std::make_shared<DynSub>(type, gens);
+    b.add("dynsub/block16/" + name + "/xfrmBlocks/4096B", 8.0 * 4096.0, [sub](std::size_t n) {
+      std::vector<std::uint8_t> data(4096);
+      for (std::size_t i = 0; i < n; i++) { sub->xfrmBlocks(data.data(), data.size() / 16); keep(data); }
+    });
+  }
+
+  /**
+   * Register the ciphering primitives' cases
+   *
+   * @param b  Harness to register into
+   * @param g  Keyed generator to use
+   */
+  void addCiphering(Bench &b, Xsg512 const &g) {
+    addDynSub<DynSubSRSD>(b, "SRSD", g);
+    addDynSub<DynSubSRDD>(b, "SRDD", g);
+    addDynSub<DynSubDRSD>(b, "DRSD", g);
+    addDynSub<DynSubDRDD>(b, "DRDD", g);
+
+    addDynSubBlocks<DynSubSRSD>(b, "SRSD", DynSubType::SRSD, g);
+    addDynSubBlocks<DynSubSRDD>(b, "SRDD", DynSubType::SRDD, g);
+    addDynSubBlocks<DynSubDRSD>(b, "DRSD", DynSubType::DRSD, g);
+    addDynSubBlocks<DynSubDRDD>(b, "DRDD", DynSubType::DRDD, g);
+
+    // wide-block substitution scaling, from a single core up to every available one (a whole ring's worth of bytes per lane per call)
+    {
+      Xsg512 x = g;
+      std::vector<value_ptr<BitGenerator>> gens;
+      for (std::size_t i = 0; i < 256; i++) { x.nextBits(64); gens.emplace_back(new Xsg512(x)); }
+      std::shared_ptr<DynSub> sub = std::make_shared<DynSub>(DynSubType::SRSD, gens);
+      std::size_t hw = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+      for (std::size_t t = 1; t <= hw; t = (t == hw ? hw + 1 : std::min(2 * t, hw))) {
+        std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(t);
+        b.add("dynsub/block256/SRSD/xfrmBlocks/65536B/threads/" + std::to_string(t), 8.0 * 65536.0, [sub, pool](std::size_t n) {
+          std::vector<std::uint8_t> data(65536);
+          for (std::size_t i = 0; i < n; i++) { sub->xfrmBlocks(data.data(), data.size() / 256, *pool); keep(data); }
+        });
+      }
+    }
+
+    // streaming substitution, single-lane and 16-lane, in memory, to a file descriptor and through a stream buffer
+    for (std::size_t w : {std::size_t(1), std::size_t(16)}) {
+      Xsg512 x = g;
+      std::vector<value_ptr<BitGenerator>> gens;
+      for (std::size_t i = 0; i < w; i++) { x.nextBits(64); gens.emplace_back(new Xsg512(x)); }
+      std::string name = "dynsubStream/SRSD/" + std::to_string(w) + "lane";
+      std::shared_ptr<DynSubStream> enc = std::make_shared<DynSubStream>(DynSub(DynSubType::SRSD, gens));
+      std::shared_ptr<DynSubStream> dec = std::make_shared<DynSubStream>(InvDynSub(DynSubType::SRSD, gens));
+      b.add(name + "/xfrm/65536B", 8.0 * 65536.0, [enc](std::size_t n) {
+        std::vector<std::uint8_t> data(65536);
+        for (std::size_t i = 0; i < n; i++) { enc->xfrm(data.data(), data.size()); keep(data); }
+      });
+      b.add(name + "/inverse/xfrm/65536B", 8.0 * 65536.0, [dec](std::size_t n) {
+        std::vector<std::uint8_t> data(65536);
+        for (std::size_t i = 0; i < n; i++) { dec->xfrm(data.data(), data.size()); keep(data); }
+      });
+      b.add(name + "/fd/65536B", 8.0 * 65536.0, [enc](std::size_t n) {
+        std::vector<std::uint8_t> data(65536);
+        int fd = open("/dev/null", O_WRONLY);
+        for (std::size_t i = 0; i < n; i++) { enc->write(fd, data.data(), data.size()); }
+        close(fd);
+      });
+      std::shared_ptr<DynSub> sub = std::make_shared<DynSub>(DynSubType::SRSD, gens);
+      b.add(name + "/streambuf/65536B", 8.0 * 65536.0, [sub](std::size_t n) {
+        std::string data(65536, '\0');
+        std::stringbuf sink;
+        DynSubStreamBuf buf(*sub, sink);
+        std::ostream os(&buf);
+        for (std::size_t i = 0; i < n; i++) { os.write(data.data(), static_cast<std::streamsize>(data.size())); os.flush(); sink.str(""); }
+      });
+    }
+
+    for (std::size_t w : {std::size_t(64), std::size_t(512), std::size_t(2048), std::size_t(8192)}) {
+      // both directions are built from the same generator state, so that they are mutually inverse
+      Xsg512 fwdGen = g, invGen = g;
+      std::shared_ptr<DynTrans> fwd = std::make_shared<DynTrans>(fwdGen, w);
+      std::shared_ptr<InvDynTrans> inv = std::make_shared<InvDynTrans>(invGen, w);
+      std::string msg = message(w);
+      std::vector<std::uint8_t> plain(msg.begin(), msg.end()), cipher = fwd->xfrm(plain);
+      b.add("dyntrans/xfrm/" + std::to_string(w), 8.0 * static_cast<double>(w), [fwd, plain](std::size_t n) {
+        for (std::size_t i = 0; i < n; i++) { keep(fwd->xfrm(plain)); }
+      });
+      b.add("invdyntrans/xfrm/" + std::to_string(w), 8.0 * static_cast<double>(w), [inv, cipher](std::size_t n) {
+        for (std::size_t i = 0; i < n; i++) { keep(inv->xfrm(cipher)); }
+      });
+      b.add("dyntrans/construct/" + std::to_string(w), 0, [x = g, w](std::size_t n) mutable {
+        for (std::size_t i = 0; i < n; i++) { DynTrans t(x, w); keep(t); }
+      });
+    }
+
+    // bounded sampling, a fresh multiply-shift draw per call against the entropy-conserving reservoir
+    b.add("randRange/523", 0, [x = g](std::size_t n) mutable {
+      for (std::size_t i = 0; i < n; i++) { keep(randRange(x, 523)); }
+    });
+    b.add("bitReservoir/uniform/523", 0, [x = g](std::size_t n) mutable {
+      BitReservoir res(x);
+      for (std::size_t i = 0; i < n; i++) { keep(res.uniform(523)); }
+    });
+
+    // bulk variates, per variate
+    b.add("randRangeFill/523", 0, [x = g](std::size_t n) mutable {
+      std::vector<std::uint64_t> out(4096);
+      BitReservoir res(x);
+      for (std::size_t i = 0; i < n; i += out.size()) { randRangeFill(res, 0, 523, out.data(), std::min(n - i, out.size())); keep(out); }
+    });
+    b.add("uniformDoubles", 52, [x = g](std::size_t n) mutable {
+      std::vector<double> out(4096);
+      BitReservoir res(x);
+      for (std::size_t i = 0; i < n; i += out.size()) { uniformDoubles(res, out.data(), std::min(n - i, out.size())); keep(out); }
+    });
+    b.add("uniformFloats", 23, [x = g](std::size_t n) mutable {
+      std::vector<float> out(4096);
+      BitReservoir res(x);
+      for (std::size_t i = 0; i < n; i += out.size()) { uniformFloats(res, out.data(), std::min(n - i, out.size())); keep(out); }
+    });
+
+    for (std::size_t len : {std::size_t(256), std::size_t(4096), std::size_t(65536)}) {
+      b.add("generateAndShufflePermutation/" + std::to_string(len), 0, [x = g, len](std::size_t n) mutable {
+        for (std::size_t i = 0; i < n; i++) { keep(generateAndShufflePermutation<std::uint16_t>(x, len)); }
+      });
+    }
+
+    // sparse sampling over a large index space
+    b.add("samplePartialPermutation/4294967296/1024", 0, [x = g](std::size_t n) mutable {
+      for (std::size_t i = 0; i < n; i++) { keep(samplePartialPermutation(x, std::uint64_t(1) << 32, 1024)); }
+    });
+    b.add("sampleSubset/4294967296/1024", 0, [x = g](std::size_t n) mutable {
+      for (std::size_t i = 0; i < n; i++) { keep(sampleSubset(x, std::uint64_t(1) << 32, 1024)); }
+    });
+
+    // large permutation inversion and composition, serial and on every available core
+    std::size_t hw = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(hw);
+    for (std::size_t len : {std::size_t(1) << 16, std::size_t(1) << 20, std::size_t(1) << 23}) {
+      std::shared_ptr<PermutationPair> pq = std::make_shared<PermutationPair>();
+      b.add("invertPermutation/" + std::to_string(len), 0, [pq, len](std::size_t n) {
+        Permutation<std::uint32_t> const &p = shuffled(*pq, len).first;
+        for (std::size_t i = 0; i < n; i++) { keep(invertPermutation(p)); }
+      });
+      b.add("invertPermutation/" + std::to_string(len) + "/threads/" + std::to_string(hw), 0, [pq, len, pool](std::size_t n) {
+        Permutation<std::uint32_t> const &p = shuffled(*pq, len).first;
+        for (std::size_t i = 0; i < n; i++) { keep(invertPermutation(p, *pool)); }
+      });
+      b.add("compose/" + std::to_string(len), 0, [pq, len](std::size_t n) {
+        PermutationPair const &r = shuffled(*pq, len);
+        for (std::size_t i = 0; i < n; i++) { keep(compose(r.first, r.second)); }
+      });
+      b.add("compose/" + std::to_string(len) + "/threads/" + std::to_string(hw), 0, [pq, len, pool](std::size_t n) {
+        PermutationPair const &r = shuffled(*pq, len);
+        for (std::size_t i = 0; i < n; i++) { keep(compose(r.first, r.second, *pool)); }
+      });
+    }
+  }
+
+  /**
+   * Register the stream monitoring cases
+   *
+   * Monitoring overhead is the difference between the monitored and bare
+   * keystream cases, relative to the latter.
+   *
+   * @param b  Harness to register into
+   * @param g  Keyed generator to use
+   */
+  void addMonitoring(Bench &b, Xsg512 const &g) {
+    constexpr std::size_t len = std::size_t(1) << 16;
+
+    std::shared_ptr<std::vector<std::uint8_t>> data = std::make_shared<std::vector<std::uint8_t>>(std::size_t(1) << 20);
+    Xsg512 x = g;
+    Xsg512::XofReader(x).read(data->data(), data->size());
+    std::shared_ptr<StreamMonitor> mon = std::make_shared<StreamMonitor>();
+    b.add("streamMonitor/feed/1048576B", 8.0 * static_cast<double>(data->size()), [mon, data](std::size_t n) {
+      for (std::size_t i = 0; i < n; i++) { mon->feed(data->data(), data->size()); }
+      keep(mon->bits());
+    });
+
+    b.add("xsg512/xof/" + std::to_string(len) + "B", 8.0 * len, [x = g](std::size_t n) mutable {
+      std::vector<std::uint8_t> out(len);
+      Xsg512::XofReader r(x);
+      for (std::size_t i = 0; i < n; i++) { r.read(out.data(), len); keep(out); }
+    });
+
+    std::shared_ptr<StreamMonitor> xmon = std::make_shared<StreamMonitor>();
+    b.add("xsg512/xof+monitor/" + std::to_string(len) + "B", 8.0 * len, [x = g, xmon](std::size_t n) mutable {
+      std::vector<std::uint8_t> out(len);
+      Xsg512::XofReader r(x);
+      for (std::size_t i = 0; i < n; i++) { r.read(out.data(), len); xmon->feed(out.data(), len); keep(out); }
+    });
+  }
+
+  /**
+   * Print usage information
+   *
+   * @param prog  Program name
+   */
+  void usage(char const *prog) {
+    std::cerr << "Usage: " << prog << " [options]" << std::endl
+              << "  --filter PATTERN    only run cases whose name contains PATTERN (may be repeated)" << std::endl
+              << "  --json FILE         write the results as JSON to FILE" << std::endl
+              << "  --baseline FILE     compare the results against the JSON baseline in FILE" << std::endl
+              << "  --threshold X       allowed median slowdown against the baseline, as a fraction (default 0.10)" << std::endl
+              << "  --min-samples N     minimum number of samples per case (default 5)" << std::endl
+              << "  --max-samples N     maximum number of samples per case (default 101)" << std::endl
+              << "  --sample-ms T       target duration of a single sample, in milliseconds (default 10)" << std::endl
+              << "  --budget-ms T       time budget per case, in milliseconds (default 1000)" << std::endl
+              << "  --perf              collect hardware performance counters, where available" << std::endl;
+  }
+}
+
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> filters;
+  std::string json, baseline;
+  double threshold = 0.10;
+  bool perf = false;
+  std::size_t minSamples = 5, maxSamples = 101, sampleMs = 10, budgetMs = 1000;
+
+  // parse arguments
+  std::vector<std::string> args(argv + 1, argv + argc);
+  for (std::size_t i = 0; i < args.size(); i++) {
+    bool more = i + 1 < args.size();
+    if      ("--filter"      == args[i] && more) { filters.push_back(args[++i]); }
+    else if ("--json"        == args[i] && more) { json = args[++i]; }
+    else if ("--baseline"    == args[i] && more) { baseline = args[++i]; }
+    else if ("--threshold"   == args[i] && more) { threshold = std::strtod(args[++i].c_str(), nullptr); }
+    else if ("--min-samples" == args[i] && more) { minSamples = std::strtoul(args[++i].c_str(), nullptr, 10); }
+    else if ("--max-samples" == args[i] && more) { maxSamples = std::strtoul(args[++i].c_str(), nullptr, 10); }
+    else if ("--sample-ms"   == args[i] && more) { sampleMs = std::strtoul(args[++i].c_str(), nullptr, 10); }
+    else if ("--budget-ms"   == args[i] && more) { budgetMs = std::strtoul(args[++i].c_str(), nullptr, 10); }
+    else if ("--perf"        == args[i])         { perf = true; }
+    else { usage(argv[0]); return 2; }
+  }
+
+  // register every case
+  Bench b(minSamples, maxSamples, std::chrono::milliseconds(sampleMs), std::chrono::milliseconds(budgetMs));
+  b.filter(filters).counters(perf);
+  Xsg512 g = distillXsg(benchKey);
+  addPrimitives(b, g);
+  addHashing(b, g);
+  addCiphering(b, g);
+  addMonitoring(b, g);
+
+  // run them
+#ifdef XSG_STATS
+  std::cout << "note: built with XSG_STATS, timings include statistics collection" << std::endl << std::endl;
+#endif
+  std::vector<Bench::Result> const &results = b.run(std::cout);
+
+  if (!json.empty()) {
+    std::ofstream out(json);
+    Bench::writeJson(out, results);
+    if (!out) { std::cerr << "Could not write " << json << std::endl; return 2; }
+  }
+
+  // compare against the baseline, if any
+  if (!baseline.empty()) {
+    std::ifstream in(baseline);
+    if (!in) {
+      std::cerr << "No baseline found at " << baseline << ", skipping comparison" << std::endl;
+    } else {
+      std::cout << std::endl;
+      std::size_t regressions = Bench::compare(std::cout, results, Bench::readJson(in), threshold);
+      if (0 < regressions) {
+        std::cerr << regressions << " regression(s) beyond " << 100.0 * threshold << "%" << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
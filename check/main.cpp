@@ -0,0 +1,175 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "Xsg.h"
+
+
+namespace {
+  /**
+   * Number of calls to the global operator new (in any of its forms) so far
+   *
+   */
+  std::atomic<std::size_t> allocations(0);
+
+  /**
+   * Allocate the given number of bytes, counting the allocation
+   *
+   * @param size  Number of bytes to allocate
+   * @return the allocated memory, or nullptr on failure
+   */
+  void *counted(std::size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(0 == size ? 1 : size);
+  }
+
+  /**
+   * Widest hash checked, in bits (the widest served without allocating)
+   *
+   */
+  constexpr std::size_t maxWidth = 4096;
+
+  /**
+   * Check that hashing the given message with a prepared XSG performs no allocation
+   *
+   * Both hash(s, w, out) and the hashAdd() / hashFinal(w, out) sequence are
+   * checked, for a few widths up to maxWidth.
+   *
+   * @param x    Keyed XSG to hash with
+   * @param msg  Message to hash
+   * @return the number of failing checks
+   */
+  std::size_t checkHash(Xsg512 &x, std::string const &msg) {
+    static char out[(maxWidth + 3) / 4];
+    std::size_t failures = 0;
+    for (std::size_t w : {std::size_t(1), std::size_t(64), std::size_t(127), std::size_t(512), maxWidth}) {
+      x.reset();
+      std::size_t before = allocations.load(std::memory_order_relaxed);
+      x.hash(msg, w, out);
+      x.reset();
+      x.hashAdd(msg).hashAdd(msg);
+      x.hashFinal(w, out);
+      std::size_t made = allocations.load(std::memory_order_relaxed) - before;
+      if (0 != made) {
+        std::cerr << "FAIL  xsg512/hash/" << msg.size() << "B/" << w << "b: " << made << " allocation(s)" << std::endl;
+        failures++;
+      }
+    }
+    return failures;
+  }
+}
+
+
+/**
+ * Replaced global allocation function, counting every call
+ *
+ * @param size  Number of bytes to allocate
+ * @return the allocated memory
+ * @throws std::bad_alloc  In case of allocation failure
+ */
+void *operator new(std::size_t size) {
+  void *ret = counted(size);
+  if (nullptr == ret) { throw std::bad_alloc(); }
+  return ret;
+}
+
+/**
+ * Replaced global array allocation function, counting every call
+ *
+ * @param size  Number of bytes to allocate
+ * @return the allocated memory
+ * @throws std::bad_alloc  In case of allocation failure
+ */
+void *operator new[](std::size_t size) {
+  void *ret = counted(size);
+  if (nullptr == ret) { throw std::bad_alloc(); }
+  return ret;
+}
+
+/**
+ * Replaced global non-throwing allocation function, counting every call
+ *
+ * @param size  Number of bytes to allocate
+ * @return the allocated memory, or nullptr on failure
+ */
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept {
+  return counted(size);
+}
+
+/**
+ * Replaced global non-throwing array allocation function, counting every call
+ *
+ * @param size  Number of bytes to allocate
+ * @return the allocated memory, or nullptr on failure
+ */
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept {
+  return counted(size);
+}
+
+/**
+ * Replaced global deallocation function
+ *
+ * @param p  Memory to release
+ */
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+/**
+ * Replaced global array deallocation function
+ *
+ * @param p  Memory to release
+ */
+void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+
+/**
+ * Replaced global sized deallocation function
+ *
+ * @param p  Memory to release
+ */
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+/**
+ * Replaced global sized array deallocation function
+ *
+ * @param p  Memory to release
+ */
+void operator delete[](void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+
+/**
+ * Check the allocation-free guarantees, failing if any is broken
+ *
+ * @return EXIT_SUCCESS if every check passes, EXIT_FAILURE otherwise
+ */
+int main() {
+  Xsg512 x = distillXsg("yggdrasill check key");
+  x.saveKeyedState();
+
+  // make sure allocations are actually being counted, lest every check pass vacuously
+  std::size_t before = allocations.load(std::memory_order_relaxed);
+  static std::string probe;
+  probe.assign(1024, 'x');
+  if (allocations.load(std::memory_order_relaxed) == before) {
+    std::cerr << "FAIL  allocations are not being counted" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::size_t failures = 0;
+  for (std::size_t len : {std::size_t(0), std::size_t(1), std::size_t(64), std::size_t(1000), std::size_t(65536)}) {
+    failures += checkHash(x, std::string(len, 'y'));
+  }
+
+  if (0 != failures) { return EXIT_FAILURE; }
+  std::cout << "ok  xsg512 hashing is allocation-free" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#include "BitEngine.h"
+
+#include <algorithm>
+
+
+/**
+ * Number of results drawn from the source at a time
+ *
+ */
+constexpr std::size_t BitEngine::bufferSize;
+
+
+/**
+ * Construct an engine drawing from the given source
+ *
+ * @param g  Source generator to draw from
+ */
+BitEngine::BitEngine(BitGenerator &g) noexcept : source(&g), buffer(), pos(bufferSize) {}
+
+/**
+ * Copy constructor, sharing the source but not the buffered results
+ *
+ * @param other  Engine to copy
+ */
+BitEngine::BitEngine(BitEngine const &other) noexcept : source(other.source), buffer(), pos(bufferSize) {}
+
+/**
+ * Copy assignment, sharing the source but not the buffered results
+ *
+ * @param other  Engine to copy
+ * @return the current engine
+ */
+BitEngine &BitEngine::operator=(BitEngine const &other) noexcept {
+  source = other.source;
+  pos = bufferSize;
+  return *this;
+}
+
+/**
+ * Return the next result
+ *
+ * @return the next 64 source bits, MSB-first
+ */
+BitEngine::result_type BitEngine::operator()() noexcept {
+  if (bufferSize == pos) { refill(); }
+  return buffer[pos++];
+}
+
+/**
+ * Skip the given number of results
+ *
+ * The source has no way of jumping ahead, so skipped bits are still
+ * generated, but never buffered.
+ *
+ * @param n  Number of results to skip
+ */
+void BitEngine::discard(unsigned long long n) noexcept {
+  // skip whatever is buffered first
+  std::size_t k = static_cast<std::size_t>(std::min<unsigned long long>(n, bufferSize - pos));
+  pos += k;
+  n -= k;
+  // then skip straight from the source
+  for (; 0 < n; n--) { source->nextBits(64); }
+}
+
+/**
+ * Refill the buffer from the source
+ *
+ */
+void BitEngine::refill() noexcept {
+  for (result_type &r : buffer) { r = source->nextBits(64); }
+  pos = 0;
+}
@@ -0,0 +1,125 @@
+#ifndef BIT_ENGINE_H__
+#define BIT_ENGINE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "BitGenerator.h"
+
+
+/**
+ * Uniform random bit generator adapter over a Bit Generator
+ *
+ * The engine satisfies the standard library's UniformRandomBitGenerator
+ * requirements with 64-bit results, so that any Bit Generator (notably
+ * Xsg512) can be plugged into <random> distributions, std::shuffle() and
+ * the like.
+ *
+ * Results are drawn from the source a block at a time through nextBits(),
+ * so that each result costs a fraction of a virtual call instead of 64 of
+ * them; each result packs 64 consecutive source bits, MSB-first.
+ *
+ * The source must outlive the engine, and should not be used directly
+ * while the engine is in use, as the engine may hold results buffered.
+ * Copies of the engine share the source, but start with an empty buffer
+ * (so that they never repeat the original's buffered results); the
+ * results buffered in the original are thus skipped by the copy, and
+ * the two interleave their draws from the source.
+ *
+ */
+class BitEngine {
+  public:
+    /**
+     * Result type
+     *
+     */
+    using result_type = std::uint64_t;
+
+    /**
+     * Number of results drawn from the source at a time
+     *
+     */
+    static constexpr std::size_t bufferSize = 64;
+
+    /**
+     * Construct an engine drawing from the given source
+     *
+     * @param g  Source generator to draw from
+     */
+    explicit BitEngine(BitGenerator &g) noexcept;
+
+    /**
+     * Copy constructor, sharing the source but not the buffered results
+     *
+     * @param other  Engine to copy
+     */
+    BitEngine(BitEngine const &other) noexcept;
+
+    /**
+     * Copy assignment, sharing the source but not the buffered results
+     *
+     * @param other  Engine to copy
+     * @return the current engine
+     */
+    BitEngine &operator=(BitEngine const &other) noexcept;
+
+    /**
+     * Retrieve the smallest possible result
+     *
+     * @return the smallest possible result
+     */
+    static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
+
+    /**
+     * Retrieve the largest possible result
+     *
+     * @return the largest possible result
+     */
+    static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+    /**
+     * Return the next result
+     *
+     * @return the next 64 source bits, MSB-first
+     */
+    result_type operator()() noexcept;
+
+    /**
+     * Skip the given number of results
+     *
+     * The source has no way of jumping ahead, so skipped bits are still
+     * generated, but never buffered.
+     *
+     * @param n  Number of results to skip
+     */
+    void discard(unsigned long long n) noexcept;
+
+  protected:
+    /**
+     * Refill the buffer from the source
+     *
+     */
+    void refill() noexcept;
+
+    /**
+     * Source generator
+     *
+     */
+    BitGenerator *source;
+
+    /**
+     * Buffered results
+     *
+     */
+    result_type buffer[bufferSize];
+
+    /**
+     * Position of the next buffered result (bufferSize if none remain)
+     *
+     */
+    std::size_t pos;
+};
+
+
+#endif  /* BIT_ENGINE_H__ */
@@ -1,6 +1,9 @@
 #ifndef BIT_GENERATOR_H__
 #define BIT_GENERATOR_H__
 
+#include <cstddef>
+#include <cstdint>
+
 
 /**
  * Interface for boolean generators
@@ -23,6 +26,22 @@ class BitGenerator {
      */
     virtual bool next() noexcept = 0;
 
+    /**
+     * Return the given number of output bits, packed MSB-first into a word
+     *
+     * The first bit generated ends up as the most significant of the n
+     * lowest bits of the result; implementations are encouraged to override
+     * this in order to avoid a virtual call per bit.
+     *
+     * @param n  Number of bits to generate (at most 64)
+     * @return the generated bits
+     */
+    virtual std::uint64_t nextBits(std::size_t n) noexcept {
+      std::uint64_t ret = 0;
+      for (std::size_t i = 0; i < n; i++) { ret = (ret << 1) | next(); }
+      return ret;
+    }
+
     /**
      * Virtual destructor
      *
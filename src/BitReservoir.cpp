@@ -0,0 +1,144 @@
+#include "BitReservoir.h"
+
+#include <new>
+
+#include "Random.h"
+
+
+namespace {
+  /**
+   * Upper bound for the coder's range, leaving headroom to top it up without overflow
+   *
+   */
+  constexpr std::uint64_t rangeLimit = std::uint64_t(1) << 62;
+
+  /**
+   * Largest range size served by the coder (larger ones fall back on randRange())
+   *
+   */
+  constexpr std::uint64_t coderLimit = std::uint64_t(1) << 48;
+}
+
+
+/**
+ * Construct a reservoir drawing from the given source
+ *
+ * @param g  Source generator to draw from
+ */
+BitReservoir::BitReservoir(BitGenerator &g) noexcept : source(g), buffer(0), buffered(0), range(1), value(0), consumed(0), drawn(0) {}
+
+/**
+ * Virtual placement clone (sharing the source)
+ *
+ * @param where  Memory position where to emplace
+ * @return the cloned object
+ */
+BitReservoir *BitReservoir::clone(void *where) const {
+  return nullptr == where ? new BitReservoir(*this) : new(where) BitReservoir(*this);
+}
+
+/**
+ * Return the next buffered bit
+ *
+ * @return the next bit
+ */
+bool BitReservoir::next() noexcept {
+  return 1 == nextBits(1);
+}
+
+/**
+ * Return the given number of buffered bits, packed MSB-first into a word
+ *
+ * @param n  Number of bits to generate (at most 64)
+ * @return the generated bits
+ */
+std::uint64_t BitReservoir::nextBits(std::size_t n) noexcept {
+  if (0 == n) { return 0; }
+  consumed += n;
+
+  // take whatever is buffered, refilling if not enough
+  std::uint64_t ret = 0;
+  if (buffered < n) {
+    ret = 0 == buffered ? 0 : buffer >> (64 - buffered);
+    n -= buffered;
+    buffer = source.nextBits(64);
+    buffered = 64;
+    ret = 64 == n ? 0 : ret << n;
+  }
+  ret |= buffer >> (64 - n);
+  buffer = 64 == n ? 0 : buffer << n;
+  buffered -= n;
+  return ret;
+}
+
+/**
+ * Generate a uniformly distributed random number in [0, d)
+ *
+ * @param d  Range size (0 and 1 yield 0 and consume no bits)
+ * @return the generated number
+ */
+std::uint64_t BitReservoir::uniform(std::uint64_t d) noexcept {
+  drawn++;
+  if (d <= 1) { return 0; }
+  if (coderLimit < d) { return randRange(*this, d); }
+
+  while (true) {
+    // top the value up to (nearly) 62 bits of entropy
+    if (range < rangeLimit) {
+      std::size_t s = static_cast<std::size_t>(__builtin_clzll(range)) - 2;
+      range <<= s;
+      value = (value << s) | nextBits(s);
+    }
+
+    // accept the largest multiple of d in the range, keeping the quotient as leftover entropy
+    std::uint64_t q = range / d;
+    if (value < q * d) {
+      std::uint64_t ret = value % d;
+      range = q;
+      value /= d;
+      return ret;
+    }
+
+    // otherwise keep the rejected tail, which is uniform over what remains
+    range -= q * d;
+    value -= q * d;
+  }
+}
+
+/**
+ * Generate a uniformly distributed random number in [min, max)
+ *
+ * @param min  Minimum number (inclusive)
+ * @param max  Maximum number (exclusive)
+ * @return the generated number
+ */
+std::uint64_t BitReservoir::uniform(std::uint64_t min, std::uint64_t max) noexcept {
+  return min + uniform(max - min);
+}
+
+/**
+ * Retrieve the number of source bits consumed so far
+ *
+ * @return the number of source bits consumed so far
+ */
+std::uint64_t BitReservoir::bitsConsumed() const noexcept {
+  return consumed;
+}
+
+/**
+ * Retrieve the number of bounded integers drawn so far
+ *
+ * @return the number of calls to uniform() so far
+ */
+std::uint64_t BitReservoir::samples() const noexcept {
+  return drawn;
+}
+
+/**
+ * Retrieve the average number of source bits consumed per bounded integer
+ *
+ * @return the number of source bits consumed per sample (0 if none drawn)
+ */
+double BitReservoir::bitsPerSample() const noexcept {
+  return 0 == drawn ? 0.0 : static_cast<double>(consumed) / static_cast<double>(drawn);
+}
@@ -0,0 +1,144 @@
+#ifndef BIT_RESERVOIR_H__
+#define BIT_RESERVOIR_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "BitGenerator.h"
+
+
+/**
+ * Buffering, entropy-conserving adapter over an expensive bit generator
+ *
+ * The reservoir draws bits from its source 64 at a time, and hands them out
+ * either raw (through next() and nextBits(), in the source's own order), or
+ * as uniformly distributed bounded integers (through uniform()).
+ *
+ * Bounded integers are drawn by an interval-based coder: the reservoir keeps
+ * a value uniformly distributed in [0, range), topped up with fresh bits as
+ * needed; a draw below d takes the value modulo d and keeps the quotient as
+ * a smaller uniform value for the next draw, so that (unlike rejection
+ * sampling) no entropy is thrown away save for the rare rejected tail.  This
+ * gets within a tiny fraction of a bit of log2(d) bits per draw, on average.
+ *
+ * The source must outlive the reservoir, and should not be used directly
+ * while the reservoir is in use, as the reservoir may hold up to 63 of its
+ * bits buffered.
+ *
+ */
+class BitReservoir : public BitGenerator {
+  public:
+    /**
+     * Construct a reservoir drawing from the given source
+     *
+     * @param g  Source generator to draw from
+     */
+    explicit BitReservoir(BitGenerator &g) noexcept;
+
+    /**
+     * Virtual placement clone (sharing the source)
+     *
+     * @param where  Memory position where to emplace
+     * @return the cloned object
+     */
+    virtual BitReservoir *clone(void *where = nullptr) const override;
+
+    /**
+     * Return the next buffered bit
+     *
+     * @return the next bit
+     */
+    virtual bool next() noexcept override;
+
+    /**
+     * Return the given number of buffered bits, packed MSB-first into a word
+     *
+     * @param n  Number of bits to generate (at most 64)
+     * @return the generated bits
+     */
+    virtual std::uint64_t nextBits(std::size_t n) noexcept override;
+
+    /**
+     * Generate a uniformly distributed random number in [0, d)
+     *
+     * @param d  Range size (0 and 1 yield 0 and consume no bits)
+     * @return the generated number
+     */
+    std::uint64_t uniform(std::uint64_t d) noexcept;
+
+    /**
+     * Generate a uniformly distributed random number in [min, max)
+     *
+     * @param min  Minimum number (inclusive)
+     * @param max  Maximum number (exclusive)
+     * @return the generated number
+     */
+    std::uint64_t uniform(std::uint64_t min, std::uint64_t max) noexcept;
+
+    /**
+     * Retrieve the number of source bits consumed so far
+     *
+     * @return the number of source bits consumed so far
+     */
+    std::uint64_t bitsConsumed() const noexcept __attribute__((pure));
+
+    /**
+     * Retrieve the number of bounded integers drawn so far
+     *
+     * @return the number of calls to uniform() so far
+     */
+    std::uint64_t samples() const noexcept __attribute__((pure));
+
+    /**
+     * Retrieve the average number of source bits consumed per bounded integer
+     *
+     * @return the number of source bits consumed per sample (0 if none drawn)
+     */
+    double bitsPerSample() const noexcept __attribute__((pure));
+
+  protected:
+    /**
+     * Source generator
+     *
+     */
+    BitGenerator &source;
+
+    /**
+     * Buffered source bits, the next one being the MSB
+     *
+     */
+    std::uint64_t buffer;
+
+    /**
+     * Number of buffered bits
+     *
+     */
+    std::size_t buffered;
+
+    /**
+     * Size of the interval the coder's value is uniform in
+     *
+     */
+    std::uint64_t range;
+
+    /**
+     * Coder's value, uniform in [0, range)
+     *
+     */
+    std::uint64_t value;
+
+    /**
+     * Number of source bits consumed
+     *
+     */
+    std::uint64_t consumed;
+
+    /**
+     * Number of bounded integers drawn
+     *
+     */
+    std::uint64_t drawn;
+};
+
+
+#endif  /* BIT_RESERVOIR_H__ */
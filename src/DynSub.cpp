@@ -8,6 +8,18 @@
 
 
 namespace {
+  /**
+   * Number of lanes handled together by a thread (a cache line's worth of each block)
+   *
+   */
+  constexpr std::size_t laneGroup = 64;
+
+  /**
+   * Number of blocks a lane group goes over before moving on to its next lane
+   *
+   */
+  constexpr std::size_t blockBatch = 64;
+
   /**
    * Generate a random permutation using the given Bit Generator
    *
@@ -15,10 +27,10 @@ namespace {
    * @return the permuted array
    */
   std::array<std::uint8_t, 256> generateRandomPermutation(BitGenerator &gen) noexcept {
-    std::vector<std::size_t> perm = generateAndShufflePermutation(gen, 256, 2);
+    Permutation<std::uint8_t> perm = generateAndShufflePermutation<std::uint8_t>(gen, 256, 2);
     std::array<std::uint8_t, 256> ret;
 
-    std::copy_n(perm.begin(), 256, ret.begin());
+    std::copy_n(perm.data(), 256, ret.begin());
 
     return ret;
   }
@@ -38,28 +50,91 @@ namespace {
   }
 
   /**
-   * Create a vector of Dynamic Substitutions of the given type using the given Bit Generators
+   * Transform a strided run of characters through the given substitution's own single-character transform
    *
-   * @param g  Bit Generators to use
+   * The call is qualified, so that it is resolved statically and inlined.
+   *
+   * @param S  Dynamic Substitution class
+   * @param sub     Dynamic Substitution to use
+   * @param input   First character to transform
+   * @param output  Where to write the first transformed character
+   * @param count   Number of characters to transform
+   * @param stride  Distance between consecutive characters
+   */
+  template <typename S>
+  inline void xfrmRun(S &sub, std::uint8_t const *input, std::uint8_t *output, std::size_t count, std::size_t stride) {
+    for (std::size_t k = 0; k < count; k++) {
+      output[k * stride] = sub.S::xfrm(input[k * stride]);
+    }
+  }
+
+  /**
+   * Hold a clone of the given Bit Generator
+   *
+   * @param g  Bit Generator (or holder thereof) to clone
+   * @return the held clone
+   */
+  inline value_ptr<BitGenerator> hold(BitGenerator const &g) {
+    return g.clone();
+  }
+  inline value_ptr<BitGenerator> hold(value_ptr<BitGenerator> const &g) {
+    return g;
+  }
+
+  /**
+   * Create a block-level Dynamic Substitution of the given type using the given Bit Generators
+   *
+   * This is the only place the type is dispatched upon, every block
+   * transformation thereafter runs the selected instantiation's loop.
+   *
+   * @param G  Bit Generator holder type (cloned by hold())
    * @param t  Dynamic Substitution type to create
-   * @return the created vector of Dynamic Substitutions
+   * @param g  Bit Generators to use
+   * @return the created block-level Dynamic Substitution
+   * @throws std::invalid_argument  if the type is unknown
    */
-  std::vector<value_ptr<DynSubSRSD>> createSubs(DynSubType const t, std::vector<BitGenerator> &g) {
-    std::vector<value_ptr<DynSubSRSD>> ret;
+  template <typename G>
+  value_ptr<DynSubBlocks> createBlocks(DynSubType const t, std::vector<G> const &g) {
+    std::vector<value_ptr<BitGenerator>> gens;
     for (std::size_t i = 0; i < g.size(); i++) {
-      switch (t) {
-        case DynSubType::SingleRandomSingleData: ret.push_back(new DynSubSRSD(g[i])); break;
-        case DynSubType::SingleRandomDoubleData: ret.push_back(new DynSubSRDD(g[i])); break;
-        case DynSubType::DoubleRandomSingleData: ret.push_back(new DynSubDRSD(g[i])); break;
-        case DynSubType::DoubleRandomDoubleData: ret.push_back(new DynSubDRDD(g[i])); break;
-        default: break;
-      }
+      gens.push_back(hold(g[i]));
+    }
+    switch (t) {
+      case DynSubType::SingleRandomSingleData: return new DynSubT<DynSubSRSD>(gens);
+      case DynSubType::SingleRandomDoubleData: return new DynSubT<DynSubSRDD>(gens);
+      case DynSubType::DoubleRandomSingleData: return new DynSubT<DynSubDRSD>(gens);
+      case DynSubType::DoubleRandomDoubleData: return new DynSubT<DynSubDRDD>(gens);
+      default: throw new std::invalid_argument("Unknown Dynamic Substitution type");
+    }
+  }
+
+  /**
+   * Create a block-level Dynamic Substitution's Inverse of the given type using the given Bit Generators
+   *
+   * @param t  Dynamic Substitution type to create
+   * @param g  Bit Generators to use
+   * @return the created block-level Dynamic Substitution's Inverse
+   * @throws std::invalid_argument  if the type is unknown
+   */
+  DynSubBlocks *createInvBlocks(DynSubType const t, std::vector<value_ptr<BitGenerator>> const &g) {
+    switch (t) {
+      case DynSubType::SingleRandomSingleData: return new DynSubT<InvDynSubSRSD>(g);
+      case DynSubType::SingleRandomDoubleData: return new DynSubT<InvDynSubSRDD>(g);
+      case DynSubType::DoubleRandomSingleData: return new DynSubT<InvDynSubDRSD>(g);
+      case DynSubType::DoubleRandomDoubleData: return new DynSubT<InvDynSubDRDD>(g);
+      default: throw new std::invalid_argument("Unknown Dynamic Substitution type");
     }
-    return ret;
   }
 }
 
 
+/**
+ * Number of random bytes drawn from the Bit Generator at a time
+ *
+ */
+constexpr std::size_t DynSubSRSD::ringSize;
+
+
 /**
  * Virtual placement clone
  *
@@ -75,7 +150,35 @@ DynSubSRSD *DynSubSRSD::clone(void *where) const {
  *
  * @param g  Bit Generator to use
  */
-DynSubSRSD::DynSubSRSD(BitGenerator const &g) : gen(g.clone()), fwd(generateRandomPermutation(*gen)) {}
+DynSubSRSD::DynSubSRSD(BitGenerator const &g) : gen(g.clone()), fwd(generateRandomPermutation(*gen)), ring(), ringPos(ringSize) {}
+
+/**
+ * Return the next uniformly random byte, refilling the ring if exhausted
+ *
+ * Bytes are taken from the Bit Generator's bits 8 at a time, MSB-first,
+ * exactly as randRange(*gen, 256) would (256 being a power of two, no
+ * draw is ever rejected), so that buffering does not change the output.
+ *
+ * @return the next random byte
+ */
+inline std::uint8_t DynSubSRSD::randomByte() noexcept {
+  if (ringSize == ringPos) { refill(); }
+  return ring[ringPos++];
+}
+
+/**
+ * Refill the ring of random bytes from the Bit Generator, 64 bits at a time
+ *
+ */
+void DynSubSRSD::refill() noexcept {
+  for (std::size_t i = 0; i < ringSize; i += 8) {
+    std::uint64_t w = gen->nextBits(64);
+    for (std::size_t j = 0; j < 8; j++) {
+      ring[i + j] = static_cast<std::uint8_t>(w >> (56 - 8 * j));
+    }
+  }
+  ringPos = 0;
+}
 
 /**
  * Transform the given character through the Dynamic Substitution
@@ -84,7 +187,7 @@ DynSubSRSD::DynSubSRSD(BitGenerator const &g) : gen(g.clone()), fwd(generateRand
  * @return the transformed character
  */
 std::uint8_t DynSubSRSD::xfrm(std::uint8_t c) {
-  std::uint8_t result = fwd[c], rnd = static_cast<std::uint8_t>(randRange(*gen, 256));
+  std::uint8_t result = fwd[c], rnd = randomByte();
   std::swap(fwd[c], fwd[rnd]);
   return result;
 }
@@ -114,9 +217,9 @@ InvDynSubSRSD::InvDynSubSRSD(BitGenerator const &g) : DynSubSRSD(g), inv(generat
  * @return the transformed character
  */
 std::uint8_t InvDynSubSRSD::xfrm(std::uint8_t c) {
-  std::uint8_t result = inv[c], rnd = static_cast<std::uint8_t>(randRange(*gen, 256));
+  std::uint8_t result = inv[c], rnd = randomByte();
   std::swap(inv[c], inv[fwd[rnd]]);
-  std::swap(fwd[inv[c]], fwd[rnd]);
+  std::swap(fwd[result], fwd[rnd]);
   return result;
 }
 
@@ -138,7 +241,7 @@ DynSubSRDD *DynSubSRDD::clone(void *where) const {
  * @return the transformed character
  */
 std::uint8_t DynSubSRDD::xfrm(std::uint8_t c) {
-  std::uint8_t result = fwd[fwd[c]], rnd = static_cast<std::uint8_t>(randRange(*gen, 256));
+  std::uint8_t result = fwd[fwd[c]], rnd = randomByte();
   std::swap(fwd[fwd[c]], fwd[rnd]);
   return result;
 
@@ -161,7 +264,7 @@ InvDynSubSRDD *InvDynSubSRDD::clone(void *where) const {
  * @return the transformed character
  */
 std::uint8_t InvDynSubSRDD::xfrm(std::uint8_t c) {
-  std::uint8_t result = inv[inv[c]], tmp = inv[c], rnd = static_cast<std::uint8_t>(randRange(*gen, 256));
+  std::uint8_t result = inv[inv[c]], tmp = inv[c], rnd = randomByte();
   std::swap(inv[c], inv[fwd[rnd]]);
   std::swap(fwd[tmp], fwd[rnd]);
   return result;
@@ -185,7 +288,7 @@ DynSubDRSD *DynSubDRSD::clone(void *where) const {
  * @return the transformed character
  */
 std::uint8_t DynSubDRSD::xfrm(std::uint8_t c) {
-  std::uint8_t result = fwd[c], rnd = static_cast<std::uint8_t>(randRange(*gen, 256)) ^ fwd[static_cast<std::uint8_t>(randRange(*gen, 256))];
+  std::uint8_t result = fwd[c], rnd = randomByte() ^ fwd[randomByte()];
   std::swap(fwd[c], fwd[rnd]);
   return result;
 }
@@ -207,7 +310,7 @@ InvDynSubDRSD *InvDynSubDRSD::clone(void *where) const {
  * @return the transformed character
  */
 std::uint8_t InvDynSubDRSD::xfrm(std::uint8_t c) {
-  std::uint8_t result = inv[c], rnd = static_cast<std::uint8_t>(randRange(*gen, 256)) ^ fwd[static_cast<std::uint8_t>(randRange(*gen, 256))];
+  std::uint8_t result = inv[c], rnd = randomByte() ^ fwd[randomByte()];
   std::swap(inv[c], inv[fwd[rnd]]);
   std::swap(fwd[result], fwd[rnd]);
   return result;
@@ -231,7 +334,7 @@ DynSubDRDD *DynSubDRDD::clone(void *where) const {
  * @return the transformed character
  */
 std::uint8_t DynSubDRDD::xfrm(std::uint8_t c) {
-  std::uint8_t result = fwd[fwd[c]], rnd = static_cast<std::uint8_t>(randRange(*gen, 256)) ^ fwd[static_cast<std::uint8_t>(randRange(*gen, 256))];
+  std::uint8_t result = fwd[fwd[c]], rnd = randomByte() ^ fwd[randomByte()];
   std::swap(fwd[fwd[c]], fwd[rnd]);
   return result;
 }
@@ -253,7 +356,7 @@ InvDynSubDRDD *InvDynSubDRDD::clone(void *where) const {
  * @return the transformed character
  */
 std::uint8_t InvDynSubDRDD::xfrm(std::uint8_t c) {
-  std::uint8_t result = inv[inv[c]], tmp = inv[c], rnd = static_cast<std::uint8_t>(randRange(*gen, 256)) ^ fwd[static_cast<std::uint8_t>(randRange(*gen, 256))];
+  std::uint8_t result = inv[inv[c]], tmp = inv[c], rnd = randomByte() ^ fwd[randomByte()];
   std::swap(inv[c], inv[fwd[rnd]]);
   std::swap(fwd[tmp], fwd[rnd]);
   return result;
@@ -261,31 +364,266 @@ std::uint8_t InvDynSubDRDD::xfrm(std::uint8_t c) {
 
 
 /**
- * Construct a Dynamic Substitution of the given width, of the given type, using the given Bit Generator
+ * Virtual placement clone
+ *
+ * @param where  Memory position where to emplace
+ * @return the cloned object
+ */
+template <typename Policy>
+DynSubT<Policy> *DynSubT<Policy>::clone(void *where) const {
+  return nullptr == where ? new DynSubT(*this) : new(where) DynSubT(*this);
+}
+
+/**
+ * Construct a block-level Dynamic Substitution, with one lane per Bit Generator given
+ *
+ * @param gens  Bit Generators to use
+ */
+template <typename Policy>
+DynSubT<Policy>::DynSubT(std::vector<value_ptr<BitGenerator>> const &gens) : lanes() {
+  lanes.reserve(gens.size());
+  for (value_ptr<BitGenerator> const &g : gens) {
+    lanes.emplace_back(*g);
+  }
+}
+
+/**
+ * Retrieve the block width
+ *
+ * @return the block width, in bytes
+ */
+template <typename Policy>
+std::size_t DynSubT<Policy>::width() const noexcept {
+  return lanes.size();
+}
+
+/**
+ * Apply the Dynamic Substitution to the given consecutive byte blocks
+ *
+ * Each lane goes over its column of every block before moving on to the
+ * next lane.  Input and output may coincide.
+ *
+ * @param input   Input byte blocks
+ * @param output  Where to write the transformed byte blocks
+ * @param blocks  Number of blocks
+ */
+template <typename Policy>
+void DynSubT<Policy>::xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks) {
+  std::size_t w = lanes.size();
+  for (std::size_t i = 0; i < w; i++) {
+    xfrmRun(lanes[i], input + i, output + i, blocks, w);
+  }
+}
+
+/**
+ * Apply the Dynamic Substitution to the given consecutive byte blocks, using the given thread pool
+ *
+ * Lanes being independent, they are split in groups spanning a cache
+ * line of each block, and groups are spread among the pool's threads;
+ * each group goes over the blocks a batch at a time, so that its lanes'
+ * tables and the batch's output stay in the core's L1.  The output is
+ * identical to the serial version's.  Input and output may coincide.
+ *
+ * @param input   Input byte blocks
+ * @param output  Where to write the transformed byte blocks
+ * @param blocks  Number of blocks
+ * @param pool    Thread pool to use
+ */
+template <typename Policy>
+void DynSubT<Policy>::xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks, ThreadPool &pool) {
+  std::size_t w = lanes.size();
+  if (pool.size() <= 1 || w < 2 * laneGroup) {
+    xfrmBlocks(input, output, blocks);
+    return;
+  }
+
+  pool.parallelFor((w + laneGroup - 1) / laneGroup, [this, input, output, blocks, w](std::size_t, std::size_t k) {
+    std::size_t first = k * laneGroup, last = std::min(w, first + laneGroup);
+    for (std::size_t b = 0; b < blocks; b += blockBatch) {
+      std::size_t c = std::min(blockBatch, blocks - b);
+      for (std::size_t i = first; i < last; i++) {
+        xfrmRun(lanes[i], input + b * w + i, output + b * w + i, c, w);
+      }
+    }
+  });
+}
+
+/**
+ * Apply the given lanes of the Dynamic Substitution to the given bytes
+ *
+ * Input and output may coincide.
+ *
+ * @param input   Input bytes (the first one going through lane first)
+ * @param output  Where to write the transformed bytes
+ * @param first   First lane to use
+ * @param count   Number of lanes to use
+ */
+template <typename Policy>
+void DynSubT<Policy>::xfrmLanes(std::uint8_t const *input, std::uint8_t *output, std::size_t first, std::size_t count) {
+  for (std::size_t i = 0; i < count; i++) {
+    output[i] = lanes[first + i].Policy::xfrm(input[i]);
+  }
+}
+
+template class DynSubT<DynSubSRSD>;
+template class DynSubT<DynSubSRDD>;
+template class DynSubT<DynSubDRSD>;
+template class DynSubT<DynSubDRDD>;
+template class DynSubT<InvDynSubSRSD>;
+template class DynSubT<InvDynSubSRDD>;
+template class DynSubT<InvDynSubDRSD>;
+template class DynSubT<InvDynSubDRDD>;
+
+
+/**
+ * Construct a Dynamic Substitution of the given type, using the given Bit Generators
+ *
+ * One substitution is built from (a clone of) each Bit Generator, so that
+ * the block width is the number of Bit Generators given.
  *
- * @param gen  Bit Generator to use
  * @param type  Type to create
- * @param width  Dynamic Substitution byte width
+ * @param gens  Bit Generators to use
+ */
+DynSub::DynSub(DynSubType const type, std::vector<BitGenerator> &gens) : impl(createBlocks(type, gens)) {}
+DynSub::DynSub(DynSubType const type, std::vector<value_ptr<BitGenerator>> const &gens) : impl(createBlocks(type, gens)) {}
+
+/**
+ * Construct a Dynamic Substitution around the given implementation
+ *
+ * @param blocks  Implementation to use (ownership is taken)
  */
-DynSub::DynSub(DynSubType const type, std::vector<BitGenerator> &gens) : subs(createSubs(type, gens)) {}
+DynSub::DynSub(DynSubBlocks *blocks) : impl(blocks) {}
+
+/**
+ * Retrieve the block width
+ *
+ * @return the block width, in bytes
+ */
+std::size_t DynSub::width() const noexcept {
+  return impl->width();
+}
 
 /**
  * Apply the Dynamic Substitution to the given byte block
  *
  * @param input  Input byte block
  * @return the transformed byte block
- * @throws
+ * @throws std::length_error  if the block's size differs from the width
  */
 std::vector<std::uint8_t> DynSub::xfrm(std::vector<std::uint8_t> const &input) {
-  if (input.size() != subs.size()) {
+  std::vector<std::uint8_t> ret(input.size());
+  xfrm(input.data(), ret.data(), input.size());
+  return ret;
+}
+
+/**
+ * Apply the Dynamic Substitution to the given byte block, without allocating
+ *
+ * Input and output may coincide.
+ *
+ * @param input   Input byte block
+ * @param output  Where to write the transformed byte block
+ * @param n       Block size
+ * @throws std::length_error  if the block's size differs from the width
+ */
+void DynSub::xfrm(std::uint8_t const *input, std::uint8_t *output, std::size_t n) {
+  if (n != impl->width()) {
     throw new std::length_error("Width mismatch");
   }
+  xfrmBlocks(input, output, 1);
+}
 
-  std::vector<std::uint8_t> ret;
-  for (std::size_t i = 0; i < subs.size(); i++) {
-    ret.push_back(subs[i]->xfrm(input[i]));
-  }
+/**
+ * Apply the Dynamic Substitution to the given byte block, in place
+ *
+ * @param data  Byte block to transform
+ * @param n     Block size
+ * @throws std::length_error  if the block's size differs from the width
+ */
+void DynSub::xfrm(std::uint8_t *data, std::size_t n) {
+  xfrm(data, data, n);
+}
 
-  return ret;
+/**
+ * Apply the Dynamic Substitution to the given consecutive byte blocks
+ *
+ * This is equivalent to transforming each block in turn, but each
+ * substitution goes over its column of every block in a single call.
+ * Input and output may coincide.
+ *
+ * @param input   Input byte blocks
+ * @param output  Where to write the transformed byte blocks
+ * @param blocks  Number of blocks
+ */
+void DynSub::xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks) {
+  impl->xfrmBlocks(input, output, blocks);
+}
+
+/**
+ * Apply the Dynamic Substitution to the given consecutive byte blocks, in place
+ *
+ * @param data    Byte blocks to transform
+ * @param blocks  Number of blocks
+ */
+void DynSub::xfrmBlocks(std::uint8_t *data, std::size_t blocks) {
+  xfrmBlocks(data, data, blocks);
+}
+
+/**
+ * Apply the Dynamic Substitution to the given consecutive byte blocks, using the given thread pool
+ *
+ * Lanes (ie. byte positions within a block) are independent, so they
+ * are split among the pool's threads; this pays off for wide blocks
+ * (hundreds of bytes or more).  The output is identical to the serial
+ * version's.  Input and output may coincide.
+ *
+ * @param input   Input byte blocks
+ * @param output  Where to write the transformed byte blocks
+ * @param blocks  Number of blocks
+ * @param pool    Thread pool to use
+ */
+void DynSub::xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks, ThreadPool &pool) {
+  impl->xfrmBlocks(input, output, blocks, pool);
 }
 
+/**
+ * Apply the Dynamic Substitution to the given consecutive byte blocks in place, using the given thread pool
+ *
+ * @param data    Byte blocks to transform
+ * @param blocks  Number of blocks
+ * @param pool    Thread pool to use
+ */
+void DynSub::xfrmBlocks(std::uint8_t *data, std::size_t blocks, ThreadPool &pool) {
+  xfrmBlocks(data, data, blocks, pool);
+}
+
+/**
+ * Apply the Dynamic Substitution to part of a byte block
+ *
+ * Bytes go through lanes [first, first + n), so that a block may be
+ * transformed piecemeal, in order.  Input and output may coincide.
+ *
+ * @param input   Input bytes
+ * @param output  Where to write the transformed bytes
+ * @param first   Position of the first byte within the block
+ * @param n       Number of bytes
+ * @throws std::length_error  if the bytes extend past the block's end
+ */
+void DynSub::xfrmPartial(std::uint8_t const *input, std::uint8_t *output, std::size_t first, std::size_t n) {
+  if (impl->width() < first || impl->width() - first < n) {
+    throw new std::length_error("Width mismatch");
+  }
+  impl->xfrmLanes(input, output, first, n);
+}
+
+
+/**
+ * Construct a Dynamic Substitution's Inverse of the given type, using the given Bit Generators
+ *
+ * Given the same type and Bit Generators, this undoes the corresponding
+ * DynSub's transformation.
+ *
+ * @param type  Type to create
+ * @param gens  Bit Generators to use
+ */
+InvDynSub::InvDynSub(DynSubType const type, std::vector<value_ptr<BitGenerator>> const &gens) : DynSub(createInvBlocks(type, gens)) {}
@@ -2,10 +2,12 @@
 #define DYN_SUB_H__
 
 #include <cstddef>
+#include <cstdint>
 #include <array>
 #include <vector>
 
 #include "BitGenerator.h"
+#include "ThreadPool.h"
 
 #include "vendors/value_ptr/value_ptr.h"
 
@@ -57,6 +59,41 @@ class DynSubSRSD {
      *
      */
     std::array<std::uint8_t, 256> fwd;
+
+    /**
+     * Number of random bytes drawn from the Bit Generator at a time
+     *
+     */
+    static constexpr std::size_t ringSize = 256;
+
+    /**
+     * Return the next uniformly random byte, refilling the ring if exhausted
+     *
+     * Bytes are taken from the Bit Generator's bits 8 at a time, MSB-first,
+     * exactly as randRange(*gen, 256) would (256 being a power of two, no
+     * draw is ever rejected), so that buffering does not change the output.
+     *
+     * @return the next random byte
+     */
+    std::uint8_t randomByte() noexcept;
+
+    /**
+     * Refill the ring of random bytes from the Bit Generator, 64 bits at a time
+     *
+     */
+    void refill() noexcept;
+
+    /**
+     * Random bytes drawn ahead
+     *
+     */
+    std::array<std::uint8_t, ringSize> ring;
+
+    /**
+     * Position of the next random byte in the ring (ringSize if exhausted)
+     *
+     */
+    std::size_t ringPos;
 };
 
 /**
@@ -294,6 +331,156 @@ enum class DynSubType {
 };
 
 
+/**
+ * Interface for block-level Dynamic Substitution implementations
+ *
+ */
+class DynSubBlocks {
+  public:
+    /**
+     * Pure virtual placement clone
+     *
+     * @param where  Memory position where to emplace
+     * @return the cloned object
+     */
+    virtual DynSubBlocks *clone(void *where = nullptr) const = 0;
+
+    /**
+     * Pure virtual method to retrieve the block width
+     *
+     * @return the block width, in bytes
+     */
+    virtual std::size_t width() const noexcept = 0;
+
+    /**
+     * Pure virtual method to apply the Dynamic Substitution to the given consecutive byte blocks
+     *
+     * Input and output may coincide.
+     *
+     * @param input   Input byte blocks
+     * @param output  Where to write the transformed byte blocks
+     * @param blocks  Number of blocks
+     */
+    virtual void xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks) = 0;
+
+    /**
+     * Pure virtual method to apply the Dynamic Substitution to the given consecutive byte blocks, using the given thread pool
+     *
+     * The output must be identical to the serial version's.  Input and
+     * output may coincide.
+     *
+     * @param input   Input byte blocks
+     * @param output  Where to write the transformed byte blocks
+     * @param blocks  Number of blocks
+     * @param pool    Thread pool to use
+     */
+    virtual void xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks, ThreadPool &pool) = 0;
+
+    /**
+     * Pure virtual method to apply the given lanes of the Dynamic Substitution to the given bytes
+     *
+     * Input and output may coincide.
+     *
+     * @param input   Input bytes (the first one going through lane first)
+     * @param output  Where to write the transformed bytes
+     * @param first   First lane to use
+     * @param count   Number of lanes to use
+     */
+    virtual void xfrmLanes(std::uint8_t const *input, std::uint8_t *output, std::size_t first, std::size_t count) = 0;
+
+    /**
+     * Virtual destructor
+     *
+     */
+    virtual ~DynSubBlocks() noexcept = default;
+};
+
+/**
+ * Block-level Dynamic Substitution over a statically known byte-level substitution
+ *
+ * Each lane is stored by value and transformed through a qualified (hence
+ * non-virtual, and inlined) call to the policy's single-character xfrm(),
+ * so that the only indirect call left is the one per xfrmBlocks() call.
+ *
+ * This template is explicitly instantiated for every byte-level
+ * Dynamic Substitution class (and their inverses) in DynSub.cpp.
+ *
+ * @param Policy  Byte-level Dynamic Substitution class
+ */
+template <typename Policy>
+class DynSubT : public DynSubBlocks {
+  public:
+    /**
+     * Virtual placement clone
+     *
+     * @param where  Memory position where to emplace
+     * @return the cloned object
+     */
+    virtual DynSubT *clone(void *where = nullptr) const override;
+
+    /**
+     * Construct a block-level Dynamic Substitution, with one lane per Bit Generator given
+     *
+     * @param gens  Bit Generators to use
+     */
+    explicit DynSubT(std::vector<value_ptr<BitGenerator>> const &gens);
+
+    /**
+     * Retrieve the block width
+     *
+     * @return the block width, in bytes
+     */
+    virtual std::size_t width() const noexcept override __attribute__((pure));
+
+    /**
+     * Apply the Dynamic Substitution to the given consecutive byte blocks
+     *
+     * Each lane goes over its column of every block before moving on to the
+     * next lane.  Input and output may coincide.
+     *
+     * @param input   Input byte blocks
+     * @param output  Where to write the transformed byte blocks
+     * @param blocks  Number of blocks
+     */
+    virtual void xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks) override;
+
+    /**
+     * Apply the Dynamic Substitution to the given consecutive byte blocks, using the given thread pool
+     *
+     * Lanes being independent, they are split in groups spanning a cache
+     * line of each block, and groups are spread among the pool's threads;
+     * each group goes over the blocks a batch at a time, so that its lanes'
+     * tables and the batch's output stay in the core's L1.  The output is
+     * identical to the serial version's.  Input and output may coincide.
+     *
+     * @param input   Input byte blocks
+     * @param output  Where to write the transformed byte blocks
+     * @param blocks  Number of blocks
+     * @param pool    Thread pool to use
+     */
+    virtual void xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks, ThreadPool &pool) override;
+
+    /**
+     * Apply the given lanes of the Dynamic Substitution to the given bytes
+     *
+     * Input and output may coincide.
+     *
+     * @param input   Input bytes (the first one going through lane first)
+     * @param output  Where to write the transformed bytes
+     * @param first   First lane to use
+     * @param count   Number of lanes to use
+     */
+    virtual void xfrmLanes(std::uint8_t const *input, std::uint8_t *output, std::size_t first, std::size_t count) override;
+
+  protected:
+    /**
+     * Byte-level Dynamic Substitutions, one per lane
+     *
+     */
+    std::vector<Policy> lanes;
+};
+
+
 /**
  * Block-level Dynamic Substitution class
  *
@@ -301,28 +488,144 @@ enum class DynSubType {
 class DynSub {
   public:
     /**
-     * Construct a Dynamic Substitution of the given type, using the given Bit Generator
+     * Construct a Dynamic Substitution of the given type, using the given Bit Generators
+     *
+     * One substitution is built from (a clone of) each Bit Generator, so that
+     * the block width is the number of Bit Generators given.
      *
-     * @param gens  Bit Generators to use
      * @param type  Type to create
+     * @param gens  Bit Generators to use
      */
     DynSub(DynSubType const type, std::vector<BitGenerator> &gens);
+    DynSub(DynSubType const type, std::vector<value_ptr<BitGenerator>> const &gens);
+
+    /**
+     * Retrieve the block width
+     *
+     * @return the block width, in bytes
+     */
+    std::size_t width() const noexcept __attribute__((pure));
 
     /**
      * Apply the Dynamic Substitution to the given byte block
      *
      * @param input  Input byte block
      * @return the transformed byte block
-     * @throws
+     * @throws std::length_error  if the block's size differs from the width
      */
     std::vector<std::uint8_t> xfrm(std::vector<std::uint8_t> const &input);
 
+    /**
+     * Apply the Dynamic Substitution to the given byte block, without allocating
+     *
+     * Input and output may coincide.
+     *
+     * @param input   Input byte block
+     * @param output  Where to write the transformed byte block
+     * @param n       Block size
+     * @throws std::length_error  if the block's size differs from the width
+     */
+    void xfrm(std::uint8_t const *input, std::uint8_t *output, std::size_t n);
+
+    /**
+     * Apply the Dynamic Substitution to the given byte block, in place
+     *
+     * @param data  Byte block to transform
+     * @param n     Block size
+     * @throws std::length_error  if the block's size differs from the width
+     */
+    void xfrm(std::uint8_t *data, std::size_t n);
+
+    /**
+     * Apply the Dynamic Substitution to the given consecutive byte blocks
+     *
+     * This is equivalent to transforming each block in turn, but each
+     * substitution goes over its column of every block in a single call.
+     * Input and output may coincide.
+     *
+     * @param input   Input byte blocks
+     * @param output  Where to write the transformed byte blocks
+     * @param blocks  Number of blocks
+     */
+    void xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks);
+
+    /**
+     * Apply the Dynamic Substitution to the given consecutive byte blocks, in place
+     *
+     * @param data    Byte blocks to transform
+     * @param blocks  Number of blocks
+     */
+    void xfrmBlocks(std::uint8_t *data, std::size_t blocks);
+
+    /**
+     * Apply the Dynamic Substitution to the given consecutive byte blocks, using the given thread pool
+     *
+     * Lanes (ie. byte positions within a block) are independent, so they
+     * are split among the pool's threads; this pays off for wide blocks
+     * (hundreds of bytes or more).  The output is identical to the serial
+     * version's.  Input and output may coincide.
+     *
+     * @param input   Input byte blocks
+     * @param output  Where to write the transformed byte blocks
+     * @param blocks  Number of blocks
+     * @param pool    Thread pool to use
+     */
+    void xfrmBlocks(std::uint8_t const *input, std::uint8_t *output, std::size_t blocks, ThreadPool &pool);
+
+    /**
+     * Apply the Dynamic Substitution to the given consecutive byte blocks in place, using the given thread pool
+     *
+     * @param data    Byte blocks to transform
+     * @param blocks  Number of blocks
+     * @param pool    Thread pool to use
+     */
+    void xfrmBlocks(std::uint8_t *data, std::size_t blocks, ThreadPool &pool);
+
+    /**
+     * Apply the Dynamic Substitution to part of a byte block
+     *
+     * Bytes go through lanes [first, first + n), so that a block may be
+     * transformed piecemeal, in order.  Input and output may coincide.
+     *
+     * @param input   Input bytes
+     * @param output  Where to write the transformed bytes
+     * @param first   Position of the first byte within the block
+     * @param n       Number of bytes
+     * @throws std::length_error  if the bytes extend past the block's end
+     */
+    void xfrmPartial(std::uint8_t const *input, std::uint8_t *output, std::size_t first, std::size_t n);
+
   protected:
     /**
-     * Dynamic Substitutions to use
+     * Construct a Dynamic Substitution around the given implementation
+     *
+     * @param blocks  Implementation to use (ownership is taken)
+     */
+    explicit DynSub(DynSubBlocks *blocks);
+
+    /**
+     * Implementation, selected by type at construction
      *
      */
-    std::vector<value_ptr<DynSubSRSD>> subs;
+    value_ptr<DynSubBlocks> impl;
+};
+
+/**
+ * Block-level Dynamic Substitution's Inverse class
+ *
+ */
+class InvDynSub : public DynSub {
+  public:
+    /**
+     * Construct a Dynamic Substitution's Inverse of the given type, using the given Bit Generators
+     *
+     * Given the same type and Bit Generators, this undoes the corresponding
+     * DynSub's transformation.
+     *
+     * @param type  Type to create
+     * @param gens  Bit Generators to use
+     */
+    InvDynSub(DynSubType const type, std::vector<value_ptr<BitGenerator>> const &gens);
 };
 
 
@@ -0,0 +1,318 @@
+#include "DynSubStream.h"
+
+#include <cerrno>
+#include <algorithm>
+#include <ios>
+#include <stdexcept>
+#include <system_error>
+
+#include <poll.h>
+#include <unistd.h>
+
+
+namespace {
+  /**
+   * Wait until the given (non-blocking) file descriptor is ready for the given events
+   *
+   * @param fd      File descriptor to wait on
+   * @param events  Events to wait for (POLLIN or POLLOUT)
+   * @return 0 once ready (or on an error condition the next call will report), the error number otherwise
+   */
+  int awaitReady(int fd, short events) noexcept {
+    pollfd p = {fd, events, 0};
+    while (poll(&p, 1, -1) < 0) {
+      if (EINTR != errno) { return errno; }
+    }
+    return 0;
+  }
+}
+
+
+/**
+ * Construct a stream over (a copy of) the given Dynamic Substitution
+ *
+ * @param s           Dynamic Substitution (or its Inverse) to use
+ * @param bufferSize  Size of the internal buffer, in bytes
+ * @throws std::invalid_argument  if the Dynamic Substitution has zero width, or the buffer size is 0
+ */
+DynSubStream::DynSubStream(DynSub const &s, std::size_t bufferSize) : sub(s), lane(0), total(0), buffer() {
+  if (0 == sub.width()) {
+    throw new std::invalid_argument("Zero width");
+  }
+  if (0 == bufferSize) {
+    throw new std::invalid_argument("Zero buffer size");
+  }
+  buffer.resize(bufferSize);
+}
+
+/**
+ * Retrieve the number of bytes transformed so far
+ *
+ * @return the stream position
+ */
+std::uint64_t DynSubStream::position() const noexcept {
+  return total;
+}
+
+/**
+ * Transform the next bytes of the stream
+ *
+ * Input and output may coincide.
+ *
+ * @param input   Input bytes
+ * @param output  Where to write the transformed bytes
+ * @param n       Number of bytes
+ * @return the current stream
+ */
+DynSubStream &DynSubStream::xfrm(std::uint8_t const *input, std::uint8_t *output, std::size_t n) {
+  std::size_t w = sub.width();
+  total += n;
+
+  // finish the current block, if started
+  if (0 < lane) {
+    std::size_t k = std::min(n, w - lane);
+    sub.xfrmPartial(input, output, lane, k);
+    input += k; output += k; n -= k;
+    lane = (lane + k) % w;
+  }
+
+  // whole blocks
+  std::size_t blocks = n / w;
+  sub.xfrmBlocks(input, output, blocks);
+  input += blocks * w; output += blocks * w; n -= blocks * w;
+
+  // start the next block
+  if (0 < n) {
+    sub.xfrmPartial(input, output, 0, n);
+    lane = n;
+  }
+
+  return *this;
+}
+
+/**
+ * Transform the next bytes of the stream, in place
+ *
+ * @param data  Bytes to transform
+ * @param n     Number of bytes
+ * @return the current stream
+ */
+DynSubStream &DynSubStream::xfrm(std::uint8_t *data, std::size_t n) {
+  return xfrm(data, data, n);
+}
+
+/**
+ * Read up to the given number of bytes from the given file descriptor, and transform them
+ *
+ * @param fd    File descriptor to read from
+ * @param data  Where to write the transformed bytes
+ * @param n     Maximum number of bytes to read
+ * @return the number of bytes read (0 on end of file)
+ * @throws std::system_error  In case reading fails
+ */
+std::size_t DynSubStream::read(int fd, std::uint8_t *data, std::size_t n) {
+  ssize_t r;
+  while ((r = ::read(fd, data, n)) < 0) {
+    int e = EINTR == errno ? 0 : EAGAIN == errno ? awaitReady(fd, POLLIN) : errno;
+    if (0 != e) {
+      throw new std::system_error(e, std::generic_category(), "dynsub stream input");
+    }
+  }
+  xfrm(data, static_cast<std::size_t>(r));
+  return static_cast<std::size_t>(r);
+}
+
+/**
+ * Read up to the given number of bytes from the given stream buffer, and transform them
+ *
+ * @param in    Stream buffer to read from
+ * @param data  Where to write the transformed bytes
+ * @param n     Maximum number of bytes to read
+ * @return the number of bytes read (less than n only on end of file)
+ */
+std::size_t DynSubStream::read(std::streambuf &in, std::uint8_t *data, std::size_t n) {
+  std::streamsize r = in.sgetn(reinterpret_cast<char *>(data), static_cast<std::streamsize>(n));
+  xfrm(data, static_cast<std::size_t>(r));
+  return static_cast<std::size_t>(r);
+}
+
+/**
+ * Transform the given bytes, and write them to the given file descriptor
+ *
+ * @param fd    File descriptor to write to
+ * @param data  Bytes to transform
+ * @param n     Number of bytes
+ * @throws std::system_error  In case writing fails
+ */
+void DynSubStream::write(int fd, std::uint8_t const *data, std::size_t n) {
+  while (0 < n) {
+    std::size_t k = std::min(n, buffer.size());
+    xfrm(data, buffer.data(), k);
+    data += k; n -= k;
+
+    for (std::uint8_t const *p = buffer.data(); 0 < k; ) {
+      ssize_t r = ::write(fd, p, k);
+      if (r < 0) {
+        int e = EINTR == errno ? 0 : EAGAIN == errno ? awaitReady(fd, POLLOUT) : errno;
+        if (0 != e) {
+          throw new std::system_error(e, std::generic_category(), "dynsub stream output");
+        }
+        continue;
+      }
+      p += r;
+      k -= static_cast<std::size_t>(r);
+    }
+  }
+}
+
+/**
+ * Transform the given bytes, and write them to the given stream buffer
+ *
+ * @param out   Stream buffer to write to
+ * @param data  Bytes to transform
+ * @param n     Number of bytes
+ * @throws std::ios_base::failure  In case writing fails
+ */
+void DynSubStream::write(std::streambuf &out, std::uint8_t const *data, std::size_t n) {
+  while (0 < n) {
+    std::size_t k = std::min(n, buffer.size());
+    xfrm(data, buffer.data(), k);
+    data += k; n -= k;
+
+    if (static_cast<std::streamsize>(k) != out.sputn(reinterpret_cast<char const *>(buffer.data()), static_cast<std::streamsize>(k))) {
+      throw new std::ios_base::failure("dynsub stream output");
+    }
+  }
+}
+
+/**
+ * Transform everything read from the given file descriptor into the other one, until end of file
+ *
+ * @param in   File descriptor to read from
+ * @param out  File descriptor to write to
+ * @return the number of bytes transformed
+ * @throws std::system_error  In case reading or writing fails
+ */
+std::uint64_t DynSubStream::pump(int in, int out) {
+  std::uint64_t start = total;
+  std::vector<std::uint8_t> raw(buffer.size());
+  while (true) {
+    ssize_t r = ::read(in, raw.data(), raw.size());
+    if (r < 0) {
+      if (EINTR == errno) { continue; }
+      throw new std::system_error(errno, std::generic_category(), "dynsub stream input");
+    }
+    if (0 == r) { break; }
+    write(out, raw.data(), static_cast<std::size_t>(r));
+  }
+  return total - start;
+}
+
+/**
+ * Transform everything read from the given stream buffer into the other one, until end of file
+ *
+ * @param in   Stream buffer to read from
+ * @param out  Stream buffer to write to
+ * @return the number of bytes transformed
+ * @throws std::ios_base::failure  In case writing fails
+ */
+std::uint64_t DynSubStream::pump(std::streambuf &in, std::streambuf &out) {
+  std::uint64_t start = total;
+  while (true) {
+    std::size_t r = read(in, buffer.data(), buffer.size());
+    if (0 == r) { break; }
+    if (static_cast<std::streamsize>(r) != out.sputn(reinterpret_cast<char const *>(buffer.data()), static_cast<std::streamsize>(r))) {
+      throw new std::ios_base::failure("dynsub stream output");
+    }
+  }
+  return total - start;
+}
+
+
+/**
+ * Construct a stream buffer over the given target
+ *
+ * @param s           Dynamic Substitution (or its Inverse) to use
+ * @param target      Stream buffer to read from or write to
+ * @param bufferSize  Size of the internal buffer, in bytes
+ * @throws std::invalid_argument  if the Dynamic Substitution has zero width, or the buffer size is 0
+ */
+DynSubStreamBuf::DynSubStreamBuf(DynSub const &s, std::streambuf &target, std::size_t bufferSize) : std::streambuf(), stream(s, 1), sink(target), area(bufferSize), failed(false) {
+  if (0 == bufferSize) {
+    throw new std::invalid_argument("Zero buffer size");
+  }
+  setp(area.data(), area.data() + area.size());
+}
+
+/**
+ * Destructor, flushes any pending output
+ *
+ */
+DynSubStreamBuf::~DynSubStreamBuf() noexcept {
+  flush();
+}
+
+/**
+ * Transform and forward pending output, then make room for the given character
+ *
+ * @param c  Character that did not fit (or EOF)
+ * @return c (or something other than EOF if c is EOF) on success, EOF otherwise
+ */
+DynSubStreamBuf::int_type DynSubStreamBuf::overflow(int_type c) {
+  if (!flush()) {
+    return traits_type::eof();
+  }
+  if (traits_type::eq_int_type(c, traits_type::eof())) {
+    return traits_type::not_eof(c);
+  }
+  *pptr() = traits_type::to_char_type(c);
+  pbump(1);
+  return c;
+}
+
+/**
+ * Transform and forward pending output, and synchronize the target
+ *
+ * @return 0 on success, -1 otherwise
+ */
+int DynSubStreamBuf::sync() {
+  return flush() && 0 == sink.pubsync() ? 0 : -1;
+}
+
+/**
+ * Pull and transform the next buffer-full of input
+ *
+ * @return the next character, or EOF
+ */
+DynSubStreamBuf::int_type DynSubStreamBuf::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  std::size_t r = stream.read(sink, reinterpret_cast<std::uint8_t *>(area.data()), area.size());
+  if (0 == r) {
+    return traits_type::eof();
+  }
+  setg(area.data(), area.data(), area.data() + r);
+  return traits_type::to_int_type(*gptr());
+}
+
+/**
+ * Transform and forward pending output, discarding it if the target fails
+ *
+ * The put area is emptied right after being transformed, so that no byte
+ * is ever transformed twice, even if forwarding it fails.
+ *
+ * @return true on success, false otherwise (always, after a failed write)
+ */
+bool DynSubStreamBuf::flush() {
+  std::streamsize n = pptr() - pbase();
+  setp(area.data(), area.data() + area.size());
+  if (failed) {
+    return false;
+  }
+  if (0 < n) {
+    stream.xfrm(reinterpret_cast<std::uint8_t *>(area.data()), static_cast<std::size_t>(n));
+    failed = n != sink.sputn(area.data(), n);
+  }
+  return !failed;
+}
@@ -0,0 +1,259 @@
+#ifndef DYN_SUB_STREAM_H__
+#define DYN_SUB_STREAM_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+#include <vector>
+
+#include "DynSub.h"
+
+
+/**
+ * Dynamic Substitution over an unbounded byte stream
+ *
+ * The stream's k-th byte goes through lane (k mod width) of the given
+ * Dynamic Substitution, so that a stream is just a sequence of blocks
+ * whose boundaries need not coincide with those of the calls made: whole
+ * blocks are handed to DynSub::xfrmBlocks(), and leading or trailing
+ * partial blocks to DynSub::xfrmPartial().  A single-lane substitution is
+ * thus a plain byte-level stream cipher.
+ *
+ * Decoding is done by a stream built over an InvDynSub of the same type
+ * and Bit Generators.
+ *
+ * Besides the in-memory transformations, adapters are provided for
+ * reading and writing file descriptors and stream buffers, through an
+ * internal buffer of the given size; non-blocking file descriptors are
+ * waited on with poll(2) whenever they are not ready.
+ *
+ */
+class DynSubStream {
+  public:
+    /**
+     * Construct a stream over (a copy of) the given Dynamic Substitution
+     *
+     * @param s           Dynamic Substitution (or its Inverse) to use
+     * @param bufferSize  Size of the internal buffer, in bytes
+     * @throws std::invalid_argument  if the Dynamic Substitution has zero width, or the buffer size is 0
+     */
+    explicit DynSubStream(DynSub const &s, std::size_t bufferSize = std::size_t(1) << 20);
+
+    /**
+     * Retrieve the number of bytes transformed so far
+     *
+     * @return the stream position
+     */
+    std::uint64_t position() const noexcept __attribute__((pure));
+
+    /**
+     * Transform the next bytes of the stream
+     *
+     * Input and output may coincide.
+     *
+     * @param input   Input bytes
+     * @param output  Where to write the transformed bytes
+     * @param n       Number of bytes
+     * @return the current stream
+     */
+    DynSubStream &xfrm(std::uint8_t const *input, std::uint8_t *output, std::size_t n);
+
+    /**
+     * Transform the next bytes of the stream, in place
+     *
+     * @param data  Bytes to transform
+     * @param n     Number of bytes
+     * @return the current stream
+     */
+    DynSubStream &xfrm(std::uint8_t *data, std::size_t n);
+
+    /**
+     * Read up to the given number of bytes from the given file descriptor, and transform them
+     *
+     * @param fd    File descriptor to read from
+     * @param data  Where to write the transformed bytes
+     * @param n     Maximum number of bytes to read
+     * @return the number of bytes read (0 on end of file)
+     * @throws std::system_error  In case reading fails
+     */
+    std::size_t read(int fd, std::uint8_t *data, std::size_t n);
+
+    /**
+     * Read up to the given number of bytes from the given stream buffer, and transform them
+     *
+     * @param in    Stream buffer to read from
+     * @param data  Where to write the transformed bytes
+     * @param n     Maximum number of bytes to read
+     * @return the number of bytes read (less than n only on end of file)
+     */
+    std::size_t read(std::streambuf &in, std::uint8_t *data, std::size_t n);
+
+    /**
+     * Transform the given bytes, and write them to the given file descriptor
+     *
+     * @param fd    File descriptor to write to
+     * @param data  Bytes to transform
+     * @param n     Number of bytes
+     * @throws std::system_error  In case writing fails
+     */
+    void write(int fd, std::uint8_t const *data, std::size_t n);
+
+    /**
+     * Transform the given bytes, and write them to the given stream buffer
+     *
+     * @param out   Stream buffer to write to
+     * @param data  Bytes to transform
+     * @param n     Number of bytes
+     * @throws std::ios_base::failure  In case writing fails
+     */
+    void write(std::streambuf &out, std::uint8_t const *data, std::size_t n);
+
+    /**
+     * Transform everything read from the given file descriptor into the other one, until end of file
+     *
+     * @param in   File descriptor to read from
+     * @param out  File descriptor to write to
+     * @return the number of bytes transformed
+     * @throws std::system_error  In case reading or writing fails
+     */
+    std::uint64_t pump(int in, int out);
+
+    /**
+     * Transform everything read from the given stream buffer into the other one, until end of file
+     *
+     * @param in   Stream buffer to read from
+     * @param out  Stream buffer to write to
+     * @return the number of bytes transformed
+     * @throws std::ios_base::failure  In case writing fails
+     */
+    std::uint64_t pump(std::streambuf &in, std::streambuf &out);
+
+  protected:
+    /**
+     * Dynamic Substitution in use
+     *
+     */
+    DynSub sub;
+
+    /**
+     * Lane the next byte goes through
+     *
+     */
+    std::size_t lane;
+
+    /**
+     * Number of bytes transformed so far
+     *
+     */
+    std::uint64_t total;
+
+    /**
+     * Buffer for the file descriptor and stream buffer adapters
+     *
+     */
+    std::vector<std::uint8_t> buffer;
+};
+
+
+/**
+ * Stream buffer applying a Dynamic Substitution stream to another stream buffer
+ *
+ * Bytes written are transformed and forwarded to the target, a buffer-full
+ * at a time (and on sync, or destruction); bytes read are pulled from the
+ * target a buffer-full at a time, and transformed.  Being a single
+ * stream, each object should be used either for reading or for writing,
+ * but not both.
+ *
+ * Pending output is transformed exactly once, whether or not the target
+ * then accepts it in full.  Once the target fails a write, the stream is
+ * out of step with any decoder and cannot be recovered: every later flush
+ * fails, and pending output is discarded.
+ *
+ */
+class DynSubStreamBuf : public std::streambuf {
+  public:
+    /**
+     * Construct a stream buffer over the given target
+     *
+     * @param s           Dynamic Substitution (or its Inverse) to use
+     * @param target      Stream buffer to read from or write to
+     * @param bufferSize  Size of the internal buffer, in bytes
+     * @throws std::invalid_argument  if the Dynamic Substitution has zero width, or the buffer size is 0
+     */
+    DynSubStreamBuf(DynSub const &s, std::streambuf &target, std::size_t bufferSize = std::size_t(1) << 20);
+
+    /**
+     * Deleted copy constructor
+     *
+     */
+    DynSubStreamBuf(DynSubStreamBuf const &) = delete;
+
+    /**
+     * Deleted copy assignment
+     *
+     */
+    DynSubStreamBuf &operator=(DynSubStreamBuf const &) = delete;
+
+    /**
+     * Destructor, flushes any pending output
+     *
+     */
+    virtual ~DynSubStreamBuf() noexcept override;
+
+  protected:
+    /**
+     * Transform and forward pending output, then make room for the given character
+     *
+     * @param c  Character that did not fit (or EOF)
+     * @return c (or something other than EOF if c is EOF) on success, EOF otherwise
+     */
+    virtual int_type overflow(int_type c) override;
+
+    /**
+     * Transform and forward pending output, and synchronize the target
+     *
+     * @return 0 on success, -1 otherwise
+     */
+    virtual int sync() override;
+
+    /**
+     * Pull and transform the next buffer-full of input
+     *
+     * @return the next character, or EOF
+     */
+    virtual int_type underflow() override;
+
+    /**
+     * Transform and forward pending output, discarding it if the target fails
+     *
+     * @return true on success, false otherwise (always, after a failed write)
+     */
+    bool flush();
+
+    /**
+     * Dynamic Substitution stream in use
+     *
+     */
+    DynSubStream stream;
+
+    /**
+     * Stream buffer read from or written to
+     *
+     */
+    std::streambuf &sink;
+
+    /**
+     * Get or put area
+     *
+     */
+    std::vector<char> area;
+
+    /**
+     * Whether a write to the target has failed
+     *
+     */
+    bool failed;
+};
+
+
+#endif  /* DYN_SUB_STREAM_H__ */
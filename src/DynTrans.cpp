@@ -590,7 +590,7 @@ namespace {
     std::vector<bool> ret;
     for (auto c : input) {
       for (std::size_t i = 0; i < 8; i++) {
-        ret.push_back(c & (0xf0u >> i));
+        ret.push_back(c & (0x80u >> i));
       }
     }
     return ret;
@@ -652,7 +652,7 @@ namespace {
     for (std::size_t i = 0; i < input.size(); i++) {
       if (count0l + count1r[i] == count1l + count0r[i]) {
         for (std::size_t j = 0; j < 16; j++) {
-          input.push_back(ergodic16[i] & (0xf000u >> j));
+          input.push_back(ergodic16[i] & (0x8000u >> j));
         }
         return true;
       }
@@ -706,7 +706,7 @@ namespace {
       while (low < high) {
         idx = (high + low) / 2;
         if (ergodic16[idx] < ind) {
-          low = idx;
+          low = idx + 1;
         } else if (ind < ergodic16[idx]) {
           high = idx;
         } else {
@@ -726,6 +726,23 @@ namespace {
 
     return true;
   }
+
+  /**
+   * Apply the given transposition to the given bit vector
+   *
+   * @param Index  Permutation index type
+   * @param bs     Bit vector to transpose
+   * @param trans  Transposition to apply
+   * @return the transposed bit vector, having bit bs[trans[i]] at position i
+   */
+  template <typename Index>
+  std::vector<bool> transpose(std::vector<bool> const &bs, Permutation<Index> const &trans) noexcept {
+    std::vector<bool> ret(trans.size());
+    for (std::size_t i = 0; i < trans.size(); i++) {
+      ret[i] = bs[trans[i]];
+    }
+    return ret;
+  }
 }
 
 
@@ -736,10 +753,15 @@ namespace {
  * @param w  Transposition width
  * @throws std::out_of_range  if w bigger than 8192
  */
-DynTrans::DynTrans(BitGenerator &gen, std::size_t w) : trans(generateAndShufflePermutation(gen, 8 * (w + 2))) {
+DynTrans::DynTrans(BitGenerator &gen, std::size_t w) : trans(), wideTrans() {
   if (w > ergodic16.size()) {
     throw new std::out_of_range("Width too big");
   }
+  if (8 * (w + 2) <= Permutation<std::uint16_t>::maxSize) {
+    trans = generateAndShufflePermutation<std::uint16_t>(gen, 8 * (w + 2));
+  } else {
+    wideTrans = generateAndShufflePermutation<std::uint32_t>(gen, 8 * (w + 2));
+  }
 }
 
 /**
@@ -754,10 +776,7 @@ std::vector<std::uint8_t> DynTrans::xfrm(std::vector<std::uint8_t> const &input)
   // 2. balance bit vector
   knuthBalance(bs);
   // 3. apply transposition
-  std::vector<bool> tr;
-  for (std::size_t i = 0; i < trans.size(); i++) {
-    tr.push_back(bs[trans[i]]);
-  }
+  std::vector<bool> tr = 0 < trans.size() ? transpose(bs, trans) : transpose(bs, wideTrans);
   // 4. bit vector to byte vector
   return fromBoolVector(tr);
 }
@@ -770,10 +789,15 @@ std::vector<std::uint8_t> DynTrans::xfrm(std::vector<std::uint8_t> const &input)
  * @param w  Transposition width
  * @throws std::out_of_range  if w bigger than 8192
  */
-InvDynTrans::InvDynTrans(BitGenerator &gen, std::size_t w) : trans(invertPermutation(generateAndShufflePermutation(gen, 8 * (w + 2)))) {
+InvDynTrans::InvDynTrans(BitGenerator &gen, std::size_t w) : trans(), wideTrans() {
   if (w > ergodic16.size()) {
     throw new std::out_of_range("Width too big");
   }
+  if (8 * (w + 2) <= Permutation<std::uint16_t>::maxSize) {
+    trans = invertPermutation(generateAndShufflePermutation<std::uint16_t>(gen, 8 * (w + 2)));
+  } else {
+    wideTrans = invertPermutation(generateAndShufflePermutation<std::uint32_t>(gen, 8 * (w + 2)));
+  }
 }
 
 /**
@@ -786,12 +810,9 @@ std::vector<std::uint8_t> InvDynTrans::xfrm(std::vector<std::uint8_t> const &inp
   // 1. byte vector to bit vector
   std::vector<bool> bs = toBoolVector(input);
   // 2. apply inverse transposition
-  std::vector<bool> tr;
-  for (std::size_t i = 0; i < trans.size(); i++) {
-    tr.push_back(bs[trans[i]]);
-  }
+  std::vector<bool> tr = 0 < trans.size() ? transpose(bs, trans) : transpose(bs, wideTrans);
   // 3. unbalance bit vector
-  knuthUnbalance(bs);
+  knuthUnbalance(tr);
   // 4. bit vector to byte vector
   return fromBoolVector(tr);
 }
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "BitGenerator.h"
+#include "Permutation.h"
 
 
 /**
@@ -33,10 +34,16 @@ class DynTrans {
 
   protected:
     /**
-     * Bit transposition to use
+     * Bit transposition to use, for blocks of up to 65536 bits (empty otherwise)
      *
      */
-    std::vector<std::size_t> trans;
+    Permutation<std::uint16_t> trans;
+
+    /**
+     * Bit transposition to use, for blocks of more than 65536 bits (empty otherwise)
+     *
+     */
+    Permutation<std::uint32_t> wideTrans;
 };
 
 
@@ -65,10 +72,16 @@ class InvDynTrans {
 
   protected:
     /**
-     * Bit transposition's inverse to use
+     * Bit transposition's inverse to use, for blocks of up to 65536 bits (empty otherwise)
+     *
+     */
+    Permutation<std::uint16_t> trans;
+
+    /**
+     * Bit transposition's inverse to use, for blocks of more than 65536 bits (empty otherwise)
      *
      */
-    std::vector<std::size_t> trans;
+    Permutation<std::uint32_t> wideTrans;
 };
 
 
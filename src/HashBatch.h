@@ -0,0 +1,44 @@
+#ifndef HASH_BATCH_H__
+#define HASH_BATCH_H__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Hasher.h"
+#include "ThreadPool.h"
+
+
+/**
+ * Hash many messages under the same key, in parallel
+ *
+ * Every message is hashed starting from the prototype's current state, as
+ * if hash() was called on a fresh copy of the prototype for each one of
+ * them; each pool participant clones the prototype at most once and
+ * resets its clone between messages, and messages are distributed among
+ * participants by work stealing.
+ *
+ * Digests are written back to back into the output buffer, each one taking
+ * exactly (w + 3) / 4 hexadecimal digits (no terminators are added).
+ *
+ * @param prototype  Keyed hasher to start every message from
+ * @param msgs       Messages to hash
+ * @param w          Width of the hashes to be generated
+ * @param out        Buffer to write msgs.size() * ((w + 3) / 4) hexadecimal digits to
+ * @param pool       Thread pool to distribute the work over
+ */
+void hashBatch(Hasher const &prototype, std::vector<std::string> const &msgs, std::size_t w, char *out, ThreadPool &pool) noexcept;
+
+/**
+ * Hash many messages under the same key, in parallel
+ *
+ * @param prototype  Keyed hasher to start every message from
+ * @param msgs       Messages to hash
+ * @param w          Width of the hashes to be generated
+ * @param pool       Thread pool to distribute the work over
+ * @return the generated hashes as hexadecimal strings, in the same order as the given messages
+ */
+std::vector<std::string> hashBatch(Hasher const &prototype, std::vector<std::string> const &msgs, std::size_t w, ThreadPool &pool) noexcept;
+
+
+#endif  /* HASH_BATCH_H__ */
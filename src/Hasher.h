@@ -26,7 +26,16 @@ class Hasher {
      * @param w    Width of the hash to be generated
      * @return the generated hash, as an hexadecimal string
      */
-    virtual std::string hash(std::string s, std::size_t w) noexcept = 0;
+    virtual std::string hash(std::string const &s, std::size_t w) noexcept = 0;
+
+    /**
+     * Generate a variable length hash into the given buffer
+     *
+     * @param s    String to hash
+     * @param w    Width of the hash to be generated
+     * @param out  Buffer to write the (w + 3) / 4 hexadecimal digits to (no terminator is added)
+     */
+    virtual void hash(std::string const &s, std::size_t w, char *out) noexcept = 0;
 
     /**
      * Add the given string to an ongoing hashing operation
@@ -34,7 +43,7 @@ class Hasher {
      * @param s  String to add
      * @return the current Hasher
      */
-    virtual Hasher &hashAdd(std::string s) noexcept = 0;
+    virtual Hasher &hashAdd(std::string const &s) noexcept = 0;
 
     /**
      * Return a hash for the elements added so far, but leave the hashing context untouched
@@ -52,6 +61,28 @@ class Hasher {
      */
     virtual std::string hashFinal(std::size_t w) noexcept = 0;
 
+    /**
+     * Finalize the hashing operation and write the calculated hash into the given buffer
+     *
+     * @param w    Hash length
+     * @param out  Buffer to write the (w + 3) / 4 hexadecimal digits to (no terminator is added)
+     */
+    virtual void hashFinal(std::size_t w, char *out) noexcept = 0;
+
+    /**
+     * Record the current state as the keyed state to return to upon reset()
+     *
+     * @return the current Hasher
+     */
+    virtual Hasher &saveKeyedState() noexcept = 0;
+
+    /**
+     * Return to the last recorded keyed state, discarding any ongoing hashing operation
+     *
+     * @return the current Hasher
+     */
+    virtual Hasher &reset() noexcept = 0;
+
     /**
      * Virtual destructor
      *
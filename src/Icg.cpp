@@ -13,7 +13,7 @@
  * @throws std::invalid_argument if the offset is 0
  */
 Icg::Icg(std::uint64_t mod, std::uint64_t mult, std::uint64_t off, std::uint64_t init)
-: m(mod), a(mult % mod), c(off % mod), x(init % mod), inv(buildInvTable(mod)) {
+: m(mod), a(mult % mod), c(off % mod), x(init % mod), succ(buildSuccTable(mod, mult % mod, off % mod)) {
   if (0 == c) {
     throw new std::invalid_argument("Zero offset found in ICG initialization");
   }
@@ -36,7 +36,7 @@ Icg &Icg::seed(std::uint64_t state) noexcept {
  * @return the current ICG
  */
 Icg &Icg::step() noexcept {
-  x = (a * inv[x] + c) % m;
+  x = succ[x];
   return *this;
 }
 
@@ -103,6 +103,24 @@ std::vector<std::uint64_t> Icg::buildInvTable(std::uint64_t mod) noexcept {
   return ret;
 }
 
+/**
+ * Construct a successor table for the given parameters
+ *
+ * @param mod   Modulus to construct the table for
+ * @param mult  Multiplier to use
+ * @param off   Offset to use
+ * @return the generated table
+ */
+std::vector<std::uint64_t> Icg::buildSuccTable(std::uint64_t mod, std::uint64_t mult, std::uint64_t off) noexcept {
+  std::vector<std::uint64_t> ret = buildInvTable(mod);
+
+  for (std::uint64_t &v : ret) {
+    v = (mult * v + off) % mod;
+  }
+
+  return ret;
+}
+
 /**
  * Return a new ICG for the given modulus, given a "mother" multiplier, an offset and an initial state
  *
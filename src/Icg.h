@@ -85,6 +85,16 @@ class Icg {
      */
     static std::vector<std::uint64_t> buildInvTable(std::uint64_t mod) noexcept;
 
+    /**
+     * Construct a successor table for the given parameters
+     *
+     * @param mod   Modulus to construct the table for
+     * @param mult  Multiplier to use
+     * @param off   Offset to use
+     * @return the generated table
+     */
+    static std::vector<std::uint64_t> buildSuccTable(std::uint64_t mod, std::uint64_t mult, std::uint64_t off) noexcept;
+
     /**
      * ICG's modulus
      *
@@ -110,10 +120,14 @@ class Icg {
     std::uint64_t x;
 
     /**
-     * Inversion table for the given modulus
+     * Successor table, mapping each state to the next one
+     *
+     * Since the state is always reduced modulo m, the whole transition
+     * function is tabulated upon construction, so that stepping amounts to a
+     * single load instead of a multiplication and a modular reduction.
      *
      */
-    std::vector<std::uint64_t> inv;
+    std::vector<std::uint64_t> succ;
 
   public:
     /**
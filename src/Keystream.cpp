@@ -0,0 +1,291 @@
+#include "Keystream.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+
+namespace {
+  /**
+   * Interval at which a writer waiting for a buffer checks the stop flag
+   *
+   */
+  constexpr std::chrono::milliseconds stopPoll{10};
+
+  /**
+   * Page-aligned buffer, along with its fill status
+   *
+   */
+  struct Slot {
+    /**
+     * Buffer data
+     *
+     */
+    std::unique_ptr<std::uint8_t, decltype(&std::free)> data{nullptr, &std::free};
+
+    /**
+     * Number of bytes generated into the buffer (0 marks the end of the stream)
+     *
+     */
+    std::size_t len = 0;
+
+    /**
+     * Whether the buffer holds data not yet released by the writer
+     *
+     */
+    bool full = false;
+  };
+
+#ifdef SPLICE_F_GIFT
+  /**
+   * Determine whether the given file descriptor is a pipe
+   *
+   * @param fd  File descriptor to check
+   * @return true if fd is a pipe (or FIFO), false otherwise
+   */
+  bool isPipe(int fd) noexcept {
+    struct stat st;
+    return 0 == fstat(fd, &st) && S_ISFIFO(st.st_mode);
+  }
+
+  /**
+   * Try to set the given pipe's capacity to the given size
+   *
+   * @param fd    Pipe to resize
+   * @param size  Capacity requested
+   * @return the pipe's resulting capacity, or 0 if it cannot be determined
+   */
+  std::size_t resizePipe(int fd, std::size_t size) noexcept {
+#ifdef F_SETPIPE_SZ
+    int got = fcntl(fd, F_SETPIPE_SZ, static_cast<int>(std::min<std::size_t>(size, 1u << 30)));
+    if (got < 0) { got = fcntl(fd, F_GETPIPE_SZ); }
+    return got < 0 ? 0 : static_cast<std::size_t>(got);
+#else
+    static_cast<void>(fd); static_cast<void>(size);
+    return 0;
+#endif
+  }
+#endif
+
+  /**
+   * Output the given buffer in full
+   *
+   * @param fd      File descriptor to output to
+   * @param data    Buffer to output
+   * @param len     Buffer length
+   * @param splice  Whether to use vmsplice(2) instead of write(2)
+   * @param stop    Flag aborting output when raised
+   * @param total   Counter to add the number of bytes output to
+   * @return 0 on success (or if stopped), the error number otherwise
+   */
+  int output(int fd, std::uint8_t const *data, std::size_t len, bool splice, std::atomic<bool> const &stop, std::uint64_t &total) noexcept {
+    while (0 < len && !stop.load(std::memory_order_relaxed)) {
+      ssize_t n;
+#ifdef SPLICE_F_GIFT
+      if (splice) {
+        iovec iov = {const_cast<std::uint8_t *>(data), len};
+        n = vmsplice(fd, &iov, 1, 0);
+      } else {
+        n = write(fd, data, len);
+      }
+#else
+      static_cast<void>(splice);
+      n = write(fd, data, len);
+#endif
+      if (n < 0) {
+        if (EAGAIN == errno) {
+          // non-blocking descriptor: wait for room, checking the stop flag every so often
+          pollfd p = {fd, POLLOUT, 0};
+          if (poll(&p, 1, static_cast<int>(stopPoll.count())) < 0 && EINTR != errno) { return errno; }
+          continue;
+        }
+        if (EINTR == errno) { continue; }
+        return errno;
+      }
+      data += n;
+      len -= static_cast<std::size_t>(n);
+      total += static_cast<std::uint64_t>(n);
+    }
+    return 0;
+  }
+
+#ifdef SPLICE_F_GIFT
+  /**
+   * Wait until the given pipe has been drained by its reader
+   *
+   * @param fd    Pipe to wait on (its writing end)
+   * @param stop  Flag giving up waiting when raised
+   * @return true if the pipe holds no more unread data (or no longer has a reader), false otherwise
+   */
+  bool drain(int fd, std::atomic<bool> const &stop) noexcept {
+    while (true) {
+      int unread = 0;
+      if (0 != ioctl(fd, FIONREAD, &unread)) { return false; }
+      if (0 == unread) { return true; }
+
+      // a pipe without a reader is reported as an error condition
+      pollfd p = {fd, POLLOUT, 0};
+      if (0 < poll(&p, 1, 0) && 0 != (p.revents & POLLERR)) { return true; }
+
+      if (stop.load(std::memory_order_relaxed)) { return false; }
+      std::this_thread::sleep_for(stopPoll);
+    }
+  }
+
+  /**
+   * Keep the given spliced buffers alive, and untouched, for the rest of the process
+   *
+   * vmsplice(2) maps the buffers' pages into the pipe instead of copying
+   * them, so they cannot be released for reuse while their contents may
+   * still be read.
+   *
+   * @param slots  Buffers to keep
+   */
+  void retire(std::vector<Slot> &slots) {
+    static std::mutex m;
+    static std::vector<Slot> retired;
+    std::lock_guard<std::mutex> lock(m);
+    for (Slot &s : slots) { retired.push_back(std::move(s)); }
+  }
+#endif
+}
+
+
+/**
+ * Write a keystream to the given file descriptor, at line rate
+ *
+ * Keystream bytes are generated into large buffers by a dedicated thread,
+ * while the calling thread writes previously generated ones out, so that
+ * generation and output overlap (double buffering).
+ *
+ * When the file descriptor is a pipe, buffers are spliced into it with
+ * vmsplice(2), avoiding the copy into the kernel; the pipe's capacity is
+ * set to the buffer size, so that a buffer may be safely refilled as soon
+ * as the one spliced after it is fully in the pipe (which implies the
+ * former has been consumed).  Otherwise, plain write(2) is used.
+ *
+ * Output stops after the given number of bytes (if not 0), when the
+ * reading end of the pipe goes away, or when the given flag is raised
+ * (eg. from a signal handler, which should be installed without
+ * SA_RESTART so that blocking writes are interrupted).  Non-blocking file
+ * descriptors are waited on with poll(2), rather than retried right away.
+ *
+ * Spliced buffers are still referenced by the pipe until read, so before
+ * returning this waits for the pipe to be drained (or its reader to go
+ * away); if stopped or failing before that, the buffers are kept
+ * allocated, and never reused, for the rest of the process.
+ *
+ * @param fd          File descriptor to write to
+ * @param fill        Function generating the given number of keystream bytes into the given buffer
+ * @param limit       Number of bytes to write (0 for no limit)
+ * @param stop        Flag stopping output when raised
+ * @param bufferSize  Size of each buffer, in bytes (rounded to the pipe's capacity when splicing)
+ * @return a summary of the run
+ * @throws std::system_error  In case output fails for any other reason than a broken pipe
+ */
+StreamReport streamKeystream(int fd, std::function<void(std::uint8_t *, std::size_t)> const &fill, std::uint64_t limit, std::atomic<bool> const &stop, std::size_t bufferSize) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::size_t const page = static_cast<std::size_t>(std::max(1L, sysconf(_SC_PAGESIZE)));
+
+  // splice into pipes whose capacity can be made to match the buffer size
+  bool splice = false;
+#ifdef SPLICE_F_GIFT
+  if (isPipe(fd)) {
+    std::size_t cap = resizePipe(fd, bufferSize);
+    if (0 < cap && 0 == cap % page) { splice = true; bufferSize = cap; }
+  }
+#endif
+  bufferSize = std::max(page, (bufferSize + page - 1) / page * page);
+
+  // a spliced buffer is only released once the next one is in the pipe, hence the extra slot
+  std::vector<Slot> slots(splice ? 3 : 2);
+  for (Slot &s : slots) {
+    void *p = nullptr;
+    if (0 != posix_memalign(&p, page, bufferSize)) { throw new std::system_error(ENOMEM, std::generic_category(), "keystream buffer"); }
+    s.data.reset(static_cast<std::uint8_t *>(p));
+  }
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool done = false;
+
+  // generate into free slots, in order
+  std::thread producer([&]() {
+    std::uint64_t produced = 0;
+    for (std::size_t k = 0; ; k = (k + 1) % slots.size()) {
+      std::size_t len = 0 == limit ? bufferSize : static_cast<std::size_t>(std::min<std::uint64_t>(bufferSize, limit - produced));
+      {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&]() { return done || !slots[k].full; });
+        if (done) { return; }
+      }
+      fill(slots[k].data.get(), len);
+      produced += len;
+      {
+        std::lock_guard<std::mutex> lock(m);
+        slots[k].len = len;
+        slots[k].full = true;
+      }
+      cv.notify_all();
+      if (0 == len) { return; }
+    }
+  });
+
+  // output full slots, in order
+  StreamReport ret = {0, std::chrono::nanoseconds(0), splice, false};
+  int failure = 0;
+  bool released = !splice;
+  for (std::size_t k = 0; !stop.load(std::memory_order_relaxed); k = (k + 1) % slots.size()) {
+    std::size_t len;
+    {
+      // the stop flag may be raised from a signal handler, which cannot notify us
+      std::unique_lock<std::mutex> lock(m);
+      while (!cv.wait_for(lock, stopPoll, [&]() { return slots[k].full || stop.load(std::memory_order_relaxed); })) {}
+      if (!slots[k].full) { break; }
+      len = slots[k].len;
+    }
+    if (0 == len) { break; }
+    failure = output(fd, slots[k].data.get(), len, splice, stop, ret.bytes);
+    if (EPIPE == failure) { ret.brokenPipe = true; failure = 0; break; }
+    if (0 != failure) { break; }
+
+    // when splicing, release the previous buffer (if any), now that this one is in the pipe
+    if (released) {
+      {
+        std::lock_guard<std::mutex> lock(m);
+        slots[splice ? (k + slots.size() - 1) % slots.size() : k].full = false;
+      }
+      cv.notify_all();
+    }
+    released = true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m);
+    done = true;
+  }
+  cv.notify_all();
+  producer.join();
+
+  // spliced buffers may not be released while the pipe may still hold them unread
+#ifdef SPLICE_F_GIFT
+  if (splice && !ret.brokenPipe && (0 != failure || !drain(fd, stop))) { retire(slots); }
+#endif
+
+  if (0 != failure) { throw new std::system_error(failure, std::generic_category(), "keystream output"); }
+  ret.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  return ret;
+}
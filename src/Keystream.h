@@ -0,0 +1,77 @@
+#ifndef KEYSTREAM_H__
+#define KEYSTREAM_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+
+/**
+ * Summary of a keystream output run
+ *
+ */
+struct StreamReport {
+  /**
+   * Number of bytes written
+   *
+   */
+  std::uint64_t bytes;
+
+  /**
+   * Wall-clock time taken
+   *
+   */
+  std::chrono::nanoseconds elapsed;
+
+  /**
+   * Whether output was spliced into a pipe (vmsplice(2)) rather than written (write(2))
+   *
+   */
+  bool spliced;
+
+  /**
+   * Whether output stopped early because the reading end went away
+   *
+   */
+  bool brokenPipe;
+};
+
+
+/**
+ * Write a keystream to the given file descriptor, at line rate
+ *
+ * Keystream bytes are generated into large buffers by a dedicated thread,
+ * while the calling thread writes previously generated ones out, so that
+ * generation and output overlap (double buffering).
+ *
+ * When the file descriptor is a pipe, buffers are spliced into it with
+ * vmsplice(2), avoiding the copy into the kernel; the pipe's capacity is
+ * set to the buffer size, so that a buffer may be safely refilled as soon
+ * as the one spliced after it is fully in the pipe (which implies the
+ * former has been consumed).  Otherwise, plain write(2) is used.
+ *
+ * Output stops after the given number of bytes (if not 0), when the
+ * reading end of the pipe goes away, or when the given flag is raised
+ * (eg. from a signal handler, which should be installed without
+ * SA_RESTART so that blocking writes are interrupted).  Non-blocking file
+ * descriptors are waited on with poll(2), rather than retried right away.
+ *
+ * Spliced buffers are still referenced by the pipe until read, so before
+ * returning this waits for the pipe to be drained (or its reader to go
+ * away); if stopped or failing before that, the buffers are kept
+ * allocated, and never reused, for the rest of the process.
+ *
+ * @param fd          File descriptor to write to
+ * @param fill        Function generating the given number of keystream bytes into the given buffer
+ * @param limit       Number of bytes to write (0 for no limit)
+ * @param stop        Flag stopping output when raised
+ * @param bufferSize  Size of each buffer, in bytes (rounded to the pipe's capacity when splicing)
+ * @return a summary of the run
+ * @throws std::system_error  In case output fails for any other reason than a broken pipe
+ */
+StreamReport streamKeystream(int fd, std::function<void(std::uint8_t *, std::size_t)> const &fill, std::uint64_t limit, std::atomic<bool> const &stop, std::size_t bufferSize = std::size_t(1) << 20);
+
+
+#endif  /* KEYSTREAM_H__ */
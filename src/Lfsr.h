@@ -55,6 +55,20 @@ class Lfsr {
      */
     constexpr bool get(std::size_t i = 0) const noexcept;
 
+    /**
+     * Get the whole current state (suitable for re-seeding)
+     *
+     * @return the current LFSR state
+     */
+    constexpr std::bitset<N> const &getState() const noexcept;
+
+    /**
+     * Get the LFSR's generator
+     *
+     * @return the LFSR's generator
+     */
+    constexpr std::bitset<N> const &getGenerator() const noexcept;
+
     /**
      * Convenience method that advances the LFSR, XORing the given value in, and returns the new output
      *
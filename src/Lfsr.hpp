@@ -104,6 +104,26 @@ constexpr bool Lfsr<N>::get(std::size_t i) const noexcept {
   return state[i];
 }
 
+/**
+ * Get the whole current state (suitable for re-seeding)
+ *
+ * @return the current LFSR state
+ */
+template <std::size_t N>
+constexpr std::bitset<N> const &Lfsr<N>::getState() const noexcept {
+  return state;
+}
+
+/**
+ * Get the LFSR's generator
+ *
+ * @return the LFSR's generator
+ */
+template <std::size_t N>
+constexpr std::bitset<N> const &Lfsr<N>::getGenerator() const noexcept {
+  return generator;
+}
+
 /**
  * Convenience method that advances the LFSR, XORing the given value in, and returns the new output
  *
@@ -0,0 +1,117 @@
+#ifndef PERMUTATION_H__
+#define PERMUTATION_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * Compact permutation of [0, size())
+ *
+ * Entries are stored with the given unsigned index type, which limits the
+ * permutation's size to 2^(8 * sizeof(Index)) elements; picking the
+ * narrowest type that fits (see PermutationIndex) keeps tables small enough
+ * to stay in cache: a 256-element permutation takes 256 bytes with
+ * std::uint8_t indices, and a 65536-element one 128 KiB with std::uint16_t
+ * indices.
+ *
+ * @param Index  Unsigned index type
+ */
+template <typename Index>
+class Permutation {
+  static_assert(std::numeric_limits<Index>::is_integer && !std::numeric_limits<Index>::is_signed && sizeof(Index) <= 4, "Permutation indices must be unsigned integers of at most 32 bits");
+
+  public:
+    /**
+     * Maximum number of elements representable
+     *
+     */
+    static constexpr std::size_t maxSize = std::size_t(std::numeric_limits<Index>::max()) + 1;
+
+    /**
+     * Construct the identity permutation of the given number of elements
+     *
+     * @param n  Number of elements
+     * @throws std::length_error  if n exceeds maxSize
+     */
+    explicit Permutation(std::size_t n = 0);
+
+    /**
+     * Retrieve the number of elements
+     *
+     * @return the number of elements
+     */
+    std::size_t size() const noexcept __attribute__((pure));
+
+    /**
+     * Retrieve the given entry
+     *
+     * @param i  Position to retrieve
+     * @return the entry at position i
+     */
+    Index operator[](std::size_t i) const noexcept __attribute__((pure));
+
+    /**
+     * Access the given entry
+     *
+     * @param i  Position to access
+     * @return a reference to the entry at position i
+     */
+    Index &operator[](std::size_t i) noexcept __attribute__((pure));
+
+    /**
+     * Access the underlying entries
+     *
+     * @return a pointer to the first entry
+     */
+    Index const *data() const noexcept __attribute__((pure));
+
+    /**
+     * Access the underlying entries
+     *
+     * @return a pointer to the first entry
+     */
+    Index *data() noexcept __attribute__((pure));
+
+    /**
+     * Compare against the given permutation, entry by entry
+     *
+     * @param other  Permutation to compare against
+     * @return true if both permutations are equal, false otherwise
+     */
+    bool operator==(Permutation const &other) const noexcept __attribute__((pure));
+
+  protected:
+    /**
+     * Entries
+     *
+     */
+    std::vector<Index> perm;
+};
+
+
+/**
+ * Narrowest standard index type able to hold a permutation of N elements
+ *
+ * @param N  Number of elements (at most 2^32)
+ */
+template <std::size_t N>
+struct PermutationIndex {
+  static_assert(N <= (std::size_t(1) << 32), "Permutations are limited to 2^32 elements");
+
+  /**
+   * Index type
+   *
+   */
+  using type = typename std::conditional<N <= (std::size_t(1) <<  8), std::uint8_t,
+               typename std::conditional<N <= (std::size_t(1) << 16), std::uint16_t,
+               std::uint32_t>::type>::type;
+};
+
+
+#include "Permutation.hpp"
+
+#endif  /* PERMUTATION_H__ */
@@ -0,0 +1,95 @@
+#ifndef PERMUTATION_HPP__
+#define PERMUTATION_HPP__
+
+#include "Permutation.h"
+
+#include <stdexcept>
+
+
+/**
+ * Maximum number of elements representable
+ *
+ */
+template <typename Index>
+constexpr std::size_t Permutation<Index>::maxSize;
+
+/**
+ * Construct the identity permutation of the given number of elements
+ *
+ * @param n  Number of elements
+ * @throws std::length_error  if n exceeds maxSize
+ */
+template <typename Index>
+Permutation<Index>::Permutation(std::size_t n) : perm() {
+  if (maxSize < n) {
+    throw new std::length_error("Permutation too big for its index type");
+  }
+  perm.resize(n);
+  for (std::size_t i = 0; i < n; i++) { perm[i] = static_cast<Index>(i); }
+}
+
+/**
+ * Retrieve the number of elements
+ *
+ * @return the number of elements
+ */
+template <typename Index>
+std::size_t Permutation<Index>::size() const noexcept {
+  return perm.size();
+}
+
+/**
+ * Retrieve the given entry
+ *
+ * @param i  Position to retrieve
+ * @return the entry at position i
+ */
+template <typename Index>
+Index Permutation<Index>::operator[](std::size_t i) const noexcept {
+  return perm[i];
+}
+
+/**
+ * Access the given entry
+ *
+ * @param i  Position to access
+ * @return a reference to the entry at position i
+ */
+template <typename Index>
+Index &Permutation<Index>::operator[](std::size_t i) noexcept {
+  return perm[i];
+}
+
+/**
+ * Access the underlying entries
+ *
+ * @return a pointer to the first entry
+ */
+template <typename Index>
+Index const *Permutation<Index>::data() const noexcept {
+  return perm.data();
+}
+
+/**
+ * Access the underlying entries
+ *
+ * @return a pointer to the first entry
+ */
+template <typename Index>
+Index *Permutation<Index>::data() noexcept {
+  return perm.data();
+}
+
+/**
+ * Compare against the given permutation, entry by entry
+ *
+ * @param other  Permutation to compare against
+ * @return true if both permutations are equal, false otherwise
+ */
+template <typename Index>
+bool Permutation<Index>::operator==(Permutation const &other) const noexcept {
+  return perm == other.perm;
+}
+
+
+#endif  /* PERMUTATION_HPP__ */
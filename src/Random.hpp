@@ -0,0 +1,328 @@
+#ifndef RANDOM_HPP__
+#define RANDOM_HPP__
+
+#include "Random.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace {
+  /**
+   * Number of indices drawn ahead of the swaps they drive (a few KiB, so as to stay in L1)
+   *
+   */
+  constexpr std::size_t shuffleBlock = 512;
+
+  /**
+   * Number of swaps to prefetch ahead of
+   *
+   */
+  constexpr std::size_t prefetchDistance = 8;
+
+  /**
+   * Bytes of permutation data assumed to stay in L2 (half a typical L2, leaving room for the streams feeding it)
+   *
+   */
+  constexpr std::size_t cacheBudget = std::size_t(1) << 17;
+
+  /**
+   * Bytes of permutation data beyond which partitioning pays off over a serial scattered write (well past the last-level cache)
+   *
+   */
+  constexpr std::size_t scatterBudget = std::size_t(1) << 26;
+
+  /**
+   * Largest number of partitions written to at once (more streams than this thrash the TLB)
+   *
+   */
+  constexpr unsigned fanOutBits = 5;
+
+  /**
+   * Number of entries composed per parallel task
+   *
+   */
+  constexpr std::size_t composeChunk = std::size_t(1) << 14;
+
+  /**
+   * Number of low bits of an index addressing within a cache-sized partition
+   *
+   * @param Index  Permutation index type
+   * @return the partition shift
+   */
+  template <typename Index>
+  constexpr unsigned partitionShift() noexcept {
+    return static_cast<unsigned>(__builtin_ctzll(cacheBudget / sizeof(Index)));
+  }
+
+  /**
+   * Run f(participant, i) for every i in [0, n), on the given pool if any, inline otherwise
+   *
+   * @param pool  Thread pool to use (nullptr to run inline)
+   * @param n     Number of indices to process
+   * @param f     Function to call for each index
+   */
+  inline void runFor(ThreadPool *pool, std::size_t n, std::function<void(std::size_t, std::size_t)> const &f) noexcept {
+    if (nullptr != pool) {
+      pool->parallelFor(n, f);
+    } else {
+      for (std::size_t i = 0; i < n; i++) { f(0, i); }
+    }
+  }
+
+  /**
+   * Invert the given permutation by radix partitioning
+   *
+   * The input is split in one chunk per participant; each chunk's
+   * (fwd[i], i) pairs are counted and then bucketed by partition, buckets
+   * being laid out partition-major so that each partition's pairs end up
+   * contiguous.  Each partition is then scattered on its own, every write
+   * landing within the same block.  Partitions are cache-sized, unless that
+   * would take more than 2^fanOutBits of them.
+   *
+   * @param Index  Permutation index type
+   * @param fwd   Forward permutation to invert
+   * @param inv   Where to write the inverse to
+   * @param n     Number of elements
+   * @param pool  Thread pool to use (nullptr to run inline)
+   */
+  template <typename Index>
+  void invertPartitioned(Index const *fwd, Index *inv, std::size_t n, ThreadPool *pool) {
+    unsigned width = static_cast<unsigned>(64 - __builtin_clzll(n - 1));
+    unsigned shift = std::max(partitionShift<Index>(), width < fanOutBits ? 0 : width - fanOutBits);
+    std::size_t parts = ((n - 1) >> shift) + 1;
+    std::size_t chunks = nullptr == pool ? 1 : pool->size();
+    std::vector<std::size_t> offset(chunks * parts, 0), start(parts + 1, 0);
+    std::unique_ptr<Index[]> staged(new Index[2 * n]);
+
+    // count each chunk's entries per partition
+    runFor(pool, chunks, [&](std::size_t, std::size_t c) {
+      std::size_t *o = &offset[c * parts];
+      std::size_t from = n * c / chunks, to = n * (c + 1) / chunks;
+      for (std::size_t i = from; i < to; i++) { o[fwd[i] >> shift]++; }
+    });
+
+    // turn counts into write offsets, partition-major
+    std::size_t total = 0;
+    for (std::size_t k = 0; k < parts; k++) {
+      start[k] = total;
+      for (std::size_t c = 0; c < chunks; c++) {
+        std::size_t cnt = offset[c * parts + k];
+        offset[c * parts + k] = total;
+        total += cnt;
+      }
+    }
+    start[parts] = total;
+
+    // bucket each chunk's pairs
+    runFor(pool, chunks, [&](std::size_t, std::size_t c) {
+      std::size_t *o = &offset[c * parts];
+      Index *st = staged.get();
+      std::size_t from = n * c / chunks, to = n * (c + 1) / chunks;
+      for (std::size_t i = from; i < to; i++) {
+        std::size_t j = o[fwd[i] >> shift]++;
+        st[2 * j] = fwd[i];
+        st[2 * j + 1] = static_cast<Index>(i);
+      }
+    });
+
+    // scatter each partition within its block
+    runFor(pool, parts, [&](std::size_t, std::size_t k) {
+      Index const *st = staged.get();
+      std::size_t from = start[k], to = start[k + 1];
+      for (std::size_t j = from; j < to; j++) { inv[st[2 * j]] = st[2 * j + 1]; }
+    });
+  }
+
+  /**
+   * Compose the given permutations' entries in [from, to)
+   *
+   * @param Index  Permutation index type
+   * @param p     First permutation's entries
+   * @param q     Second permutation's entries
+   * @param r     Where to write the composition to
+   * @param from  First entry to compose (inclusive)
+   * @param to    Last entry to compose (exclusive)
+   */
+  template <typename Index>
+  void composeRange(Index const *p, Index const *q, Index *r, std::size_t from, std::size_t to) noexcept {
+    for (std::size_t i = from; i < to; i++) {
+      if (i + prefetchDistance < to) { __builtin_prefetch(&p[q[i + prefetchDistance]]); }
+      r[i] = p[q[i]];
+    }
+  }
+}
+
+
+/**
+ * Generate a permutation of the given number of elements
+ *
+ * Indices are drawn through a BitReservoir (the given one, or a temporary
+ * one over the given Bit Generator), so as to waste as few bits as possible.
+ *
+ * @param Index  Permutation index type
+ * @param gen  Bit Generator to use
+ * @param len  Number of elements to return
+ * @return the permutation proper
+ * @throws std::length_error  if len does not fit the index type
+ */
+template <typename Index>
+Permutation<Index> generatePermutation(BitGenerator &gen, std::size_t len) {
+  BitReservoir res(gen);
+  return generatePermutation<Index>(res, len);
+}
+template <typename Index>
+Permutation<Index> generatePermutation(BitReservoir &gen, std::size_t len) {
+  Permutation<Index> ret(len);
+  std::size_t idx[shuffleBlock];
+  for (std::size_t i = 0; i < len; i += shuffleBlock) {
+    std::size_t c = std::min(shuffleBlock, len - i);
+    drawIndices(gen, i + 1, true, c, idx);
+    for (std::size_t k = 0; k < c; k++) {
+      if (k + prefetchDistance < c) { __builtin_prefetch(&ret[idx[k + prefetchDistance]]); }
+      std::size_t j = idx[k];
+      if (j != i + k) {
+        ret[i + k] = ret[j];
+      }
+      ret[j] = static_cast<Index>(i + k);
+    }
+  }
+  return ret;
+}
+
+/**
+ * Shuffle the given permutation using the given Bit Generator
+ *
+ * Indices are drawn through a BitReservoir (the given one, or a temporary
+ * one over the given Bit Generator), so as to waste as few bits as possible.
+ *
+ * @param Index  Permutation index type
+ * @param gen  Bit Generator to use
+ * @param perm  Permutation to shuffle
+ */
+template <typename Index>
+void shufflePermutation(BitGenerator &gen, Permutation<Index> &perm) noexcept {
+  BitReservoir res(gen);
+  shufflePermutation(res, perm);
+}
+template <typename Index>
+void shufflePermutation(BitReservoir &gen, Permutation<Index> &perm) noexcept {
+  std::size_t n = perm.size();
+  std::size_t idx[shuffleBlock];
+  for (std::size_t i = 0; i + 1 < n; i += shuffleBlock) {
+    std::size_t c = std::min(shuffleBlock, n - 1 - i);
+    drawIndices(gen, n - i, false, c, idx);
+    for (std::size_t k = 0; k < c; k++) {
+      if (k + prefetchDistance < c) { __builtin_prefetch(&perm[i + k + prefetchDistance + idx[k + prefetchDistance]]); }
+      std::swap(perm[i + k], perm[i + k + idx[k]]);
+    }
+  }
+}
+
+/**
+ * Generate and shuffle a permutation of the given number of elements
+ *
+ * A single BitReservoir is used throughout, so that no entropy is lost
+ * between rounds.
+ *
+ * @param Index  Permutation index type
+ * @param gen  Bit Generator to use
+ * @param len  Number of elements to return
+ * @param rep  Number of shuffling rounds to use
+ * @return the permutation proper
+ * @throws std::length_error  if len does not fit the index type
+ */
+template <typename Index>
+Permutation<Index> generateAndShufflePermutation(BitGenerator &gen, std::size_t len, std::size_t rep) {
+  BitReservoir res(gen);
+  Permutation<Index> ret = generatePermutation<Index>(res, len);
+  for (std::size_t i = 0; i < rep; i++) {
+    shufflePermutation(res, ret);
+  }
+  return ret;
+}
+
+
+/**
+ * Invert the given permutation
+ *
+ * Permutations fitting in the last-level cache are inverted by a direct
+ * scatter; larger ones are radix-partitioned first: (fwd[i], i) pairs are
+ * bucketed by the high bits of fwd[i], so that each bucket's scatter lands
+ * within a cache-sized block of the result.  Given a thread pool, anything
+ * larger than L2 is partitioned, bucketing and scattering being split among
+ * its threads (the result being the same).
+ *
+ * @param Index  Permutation index type
+ * @param fwd   Forward permutation to invert
+ * @param pool  Thread pool to use
+ * @return the inverted permutation
+ */
+template <typename Index>
+Permutation<Index> invertPermutation(Permutation<Index> const &fwd) {
+  Permutation<Index> inv(fwd.size());
+  if (fwd.size() * sizeof(Index) <= scatterBudget) {
+    for (std::size_t i = 0; i < fwd.size(); i++) {
+      inv[fwd[i]] = static_cast<Index>(i);
+    }
+  } else {
+    invertPartitioned(fwd.data(), inv.data(), fwd.size(), nullptr);
+  }
+  return inv;
+}
+template <typename Index>
+Permutation<Index> invertPermutation(Permutation<Index> const &fwd, ThreadPool &pool) {
+  if (fwd.size() * sizeof(Index) <= cacheBudget || pool.size() <= 1) {
+    return invertPermutation(fwd);
+  }
+  Permutation<Index> inv(fwd.size());
+  invertPartitioned(fwd.data(), inv.data(), fwd.size(), &pool);
+  return inv;
+}
+
+/**
+ * Compose the given permutations
+ *
+ * The result r is given by r[i] = p[q[i]], ie. gathering through r is the
+ * same as gathering through p and then through q, so that two chained
+ * transpositions can be fused into a single one.  Given a thread pool, the
+ * result is split in contiguous chunks among its threads.
+ *
+ * @param Index  Permutation index type
+ * @param p     First permutation to apply
+ * @param q     Second permutation to apply
+ * @param pool  Thread pool to use
+ * @return the composed permutation
+ * @throws std::length_error  if p and q differ in size
+ */
+template <typename Index>
+Permutation<Index> compose(Permutation<Index> const &p, Permutation<Index> const &q) {
+  if (p.size() != q.size()) {
+    throw new std::length_error("Permutation size mismatch");
+  }
+  Permutation<Index> ret(p.size());
+  composeRange(p.data(), q.data(), ret.data(), 0, p.size());
+  return ret;
+}
+template <typename Index>
+Permutation<Index> compose(Permutation<Index> const &p, Permutation<Index> const &q, ThreadPool &pool) {
+  if (p.size() != q.size()) {
+    throw new std::length_error("Permutation size mismatch");
+  }
+  if (p.size() * sizeof(Index) <= cacheBudget || pool.size() <= 1) {
+    return compose(p, q);
+  }
+  Permutation<Index> ret(p.size());
+  std::size_t n = p.size();
+  pool.parallelFor((n + composeChunk - 1) / composeChunk, [&](std::size_t, std::size_t c) {
+    composeRange(p.data(), q.data(), ret.data(), c * composeChunk, std::min(n, (c + 1) * composeChunk));
+  });
+  return ret;
+}
+
+
+#endif  /* RANDOM_HPP__ */
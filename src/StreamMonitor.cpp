@@ -0,0 +1,290 @@
+#include "StreamMonitor.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+
+namespace {
+  /**
+   * Number of words accounted for in a single pass
+   *
+   */
+  constexpr std::size_t chunkWords = 512;
+
+  /**
+   * Number of distinct byte pairs
+   *
+   */
+  constexpr std::size_t pairBins = 65536;
+
+  /**
+   * Load a word from the given bytes, so that the first byte's MSB ends up as the word's MSB
+   *
+   * @param p  Bytes to load
+   * @return the word loaded
+   */
+  inline std::uint64_t loadWord(std::uint8_t const *p) noexcept {
+    std::uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+  }
+
+  /**
+   * Count the one bits in the given word
+   *
+   * @param w  Word to count the one bits of
+   * @return the number of one bits in w
+   */
+  inline std::uint64_t popcount(std::uint64_t w) noexcept {
+    return static_cast<std::uint64_t>(__builtin_popcountll(w));
+  }
+}
+
+
+/**
+ * Construct a monitor
+ *
+ * @param threshold   Absolute z-score beyond which to alert
+ * @param handler     Alert handler (nullptr to only evaluate on demand)
+ * @param lags        Autocorrelation lags to test, each in [1, 63]
+ * @param blockWords  Block size for the block-frequency test, in 64-bit words
+ * @param interval    Number of bytes between evaluations
+ * @throws std::invalid_argument  In case a lag is out of range, or the block size is 0
+ */
+StreamMonitor::StreamMonitor(double threshold, AlertHandler handler, std::vector<std::size_t> const &lags, std::size_t blockWords, std::uint64_t interval) :
+  limit(threshold),
+  alert(handler),
+  lag(lags),
+  block(blockWords),
+  every(std::max<std::uint64_t>(1, interval)),
+  countdown(every),
+  tail(),
+  tailLen(0),
+  prev(0),
+  words(0),
+  ones(0),
+  transitions(0),
+  blockOnes(0),
+  blocks(0),
+  blockDev(0),
+  disagree(lags.size(), 0),
+  pairs(pairBins, 0)
+{
+  for (std::size_t d : lag) {
+    if (d < 1 || 63 < d) {
+      throw new std::invalid_argument("Autocorrelation lag out of range");
+    }
+  }
+  if (0 == block) {
+    throw new std::invalid_argument("Zero block size");
+  }
+}
+
+/**
+ * Feed the given output bytes to the monitor
+ *
+ * @param data  Bytes to monitor
+ * @param n     Number of bytes to monitor
+ * @return the current monitor
+ */
+StreamMonitor &StreamMonitor::feed(std::uint8_t const *data, std::size_t n) {
+  std::uint64_t w[chunkWords];
+  std::size_t left = n;
+
+  // complete the pending word, if any
+  if (0 < tailLen) {
+    std::size_t take = std::min(left, sizeof(tail) - tailLen);
+    std::memcpy(tail + tailLen, data, take);
+    tailLen += take; data += take; left -= take;
+    if (sizeof(tail) == tailLen) {
+      w[0] = loadWord(tail);
+      account(w, 1);
+      tailLen = 0;
+    }
+  }
+
+  // account for whole words, a chunk at a time
+  while (8 <= left) {
+    std::size_t k = std::min(chunkWords, left / 8);
+    for (std::size_t i = 0; i < k; i++) { w[i] = loadWord(data + 8 * i); }
+    account(w, k);
+    data += 8 * k; left -= 8 * k;
+  }
+
+  // keep the remainder pending
+  std::memcpy(tail + tailLen, data, left);
+  tailLen += left;
+
+  // evaluate, if due
+  if (countdown <= n) {
+    countdown = every;
+    if (alert) {
+      std::vector<Statistic> bad;
+      for (Statistic const &s : statistics()) {
+        if (!(std::fabs(s.z) <= limit)) { bad.push_back(s); }
+      }
+      if (!bad.empty()) { alert(bad); }
+    }
+  } else {
+    countdown -= n;
+  }
+
+  return *this;
+}
+
+/**
+ * Feed the given number of output bytes drawn from the given generator
+ *
+ * Each byte is built from 8 consecutive output bits, MSB-first.
+ *
+ * @param gen  Generator to draw from
+ * @param n    Number of bytes to draw
+ * @return the current monitor
+ */
+StreamMonitor &StreamMonitor::feed(BitGenerator &gen, std::size_t n) {
+  std::uint8_t buf[8 * chunkWords];
+  while (0 < n) {
+    std::size_t k = std::min(n, sizeof(buf));
+    for (std::size_t i = 0; i < k; i++) {
+      std::uint8_t c = 0;
+      for (std::size_t j = 0; j < 8; j++) { c = static_cast<std::uint8_t>((c << 1) | gen.next()); }
+      buf[i] = c;
+    }
+    feed(buf, k);
+    n -= k;
+  }
+  return *this;
+}
+
+/**
+ * Evaluate every test on the output seen so far
+ *
+ * @return the tests' statistics
+ */
+std::vector<StreamMonitor::Statistic> StreamMonitor::statistics() const noexcept {
+  std::vector<Statistic> ret;
+  if (0 == words) { return ret; }
+  double n = 64.0 * static_cast<double>(words);
+
+  // monobit
+  double p = static_cast<double>(ones) / n;
+  ret.push_back({"monobit", (2.0 * static_cast<double>(ones) - n) / std::sqrt(n)});
+
+  // runs (an all-equal stream has a single run, and fails outright)
+  double q = p * (1.0 - p);
+  ret.push_back({"runs", 0.0 < q ? (static_cast<double>(transitions + 1) - 2.0 * n * q) / (2.0 * std::sqrt(n) * q) : std::numeric_limits<double>::infinity()});
+
+  // block-frequency, chi-square with one degree of freedom per block
+  if (0 < blocks) {
+    double b = static_cast<double>(blocks);
+    double chi2 = static_cast<double>(blockDev) / (64.0 * static_cast<double>(block));
+    ret.push_back({"block-frequency", (chi2 - b) / std::sqrt(2.0 * b)});
+  }
+
+  // byte-pairs, chi-square with 65535 degrees of freedom, once at least 5 pairs per bin are expected
+  double np = 4.0 * static_cast<double>(words);
+  if (5.0 * pairBins <= np) {
+    double sq = 0.0;
+    for (std::uint64_t c : pairs) { sq += static_cast<double>(c) * static_cast<double>(c); }
+    double chi2 = static_cast<double>(pairBins) / np * sq - np;
+    ret.push_back({"byte-pairs", (chi2 - (pairBins - 1)) / std::sqrt(2.0 * (pairBins - 1))});
+  }
+
+  // autocorrelation
+  double nd = n - 64.0;
+  if (0.0 < nd) {
+    for (std::size_t i = 0; i < lag.size(); i++) {
+      ret.push_back({"autocorrelation/" + std::to_string(lag[i]), (2.0 * static_cast<double>(disagree[i]) - nd) / std::sqrt(nd)});
+    }
+  }
+
+  return ret;
+}
+
+/**
+ * Retrieve the number of bits accounted for so far
+ *
+ * @return the number of bits accounted for so far
+ */
+std::uint64_t StreamMonitor::bits() const noexcept {
+  return 64 * words;
+}
+
+/**
+ * Discard every tally, starting afresh
+ *
+ * @return the current monitor
+ */
+StreamMonitor &StreamMonitor::reset() noexcept {
+  countdown = every;
+  tailLen = 0;
+  prev = 0;
+  words = ones = transitions = blockOnes = blocks = blockDev = 0;
+  std::fill(disagree.begin(), disagree.end(), 0);
+  std::fill(pairs.begin(), pairs.end(), 0);
+  return *this;
+}
+
+/**
+ * Account for the given words (in stream order, MSB-first)
+ *
+ * Every tally but the byte pairs' and the block-frequency's is computed by
+ * a branch-free popcount loop, so as to be vectorized.
+ *
+ * @param w  Words to account for
+ * @param n  Number of words
+ */
+void StreamMonitor::account(std::uint64_t const *w, std::size_t n) noexcept {
+  // whether the first word pairs with a predecessor (the first word ever has none)
+  bool linked = 0 < words;
+
+  // monobit
+  std::uint64_t o = 0;
+  for (std::size_t i = 0; i < n; i++) { o += popcount(w[i]); }
+  ones += o;
+
+  // runs, within words and across word boundaries
+  std::uint64_t t = 0;
+  for (std::size_t i = 0; i < n; i++) { t += popcount((w[i] ^ (w[i] >> 1)) & (~std::uint64_t(0) >> 1)); }
+  if (linked) { t += (prev & 1) ^ (w[0] >> 63); }
+  for (std::size_t i = 1; i < n; i++) { t += (w[i - 1] & 1) ^ (w[i] >> 63); }
+  transitions += t;
+
+  // autocorrelation, pairing every bit of a word with the one d positions later
+  for (std::size_t k = 0; k < lag.size(); k++) {
+    std::size_t d = lag[k];
+    std::uint64_t a = 0;
+    if (linked) { a += popcount(prev ^ ((prev << d) | (w[0] >> (64 - d)))); }
+    for (std::size_t i = 1; i < n; i++) { a += popcount(w[i - 1] ^ ((w[i - 1] << d) | (w[i] >> (64 - d)))); }
+    disagree[k] += a;
+  }
+
+  // block-frequency
+  std::uint64_t m = 64 * block;
+  for (std::size_t i = 0; i < n; i++) {
+    blockOnes += popcount(w[i]);
+    if (0 == (words + i + 1) % block) {
+      std::uint64_t dev = 2 * blockOnes < m ? m - 2 * blockOnes : 2 * blockOnes - m;
+      blockDev += dev * dev;
+      blockOnes = 0;
+      blocks++;
+    }
+  }
+
+  // byte-pairs
+  for (std::size_t i = 0; i < n; i++) {
+    pairs[(w[i] >> 48) & 0xffff]++;
+    pairs[(w[i] >> 32) & 0xffff]++;
+    pairs[(w[i] >> 16) & 0xffff]++;
+    pairs[ w[i]        & 0xffff]++;
+  }
+
+  prev = w[n - 1];
+  words += n;
+}
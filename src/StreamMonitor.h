@@ -0,0 +1,230 @@
+#ifndef STREAM_MONITOR_H__
+#define STREAM_MONITOR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "BitGenerator.h"
+
+
+/**
+ * Incremental randomness quality monitor for bulk output
+ *
+ * The monitor is fed output bytes (bits taken MSB-first, as produced by
+ * Xsg::XofReader) and keeps running tallies for the following tests:
+ *
+ *   - monobit: balance of ones and zeros,
+ *   - runs: number of runs of equal bits,
+ *   - block-frequency: balance of ones within fixed-size blocks,
+ *   - byte-pairs: uniformity of non-overlapping pairs of bytes,
+ *   - autocorrelation/d: agreement between bits d positions apart, for a few lags d.
+ *
+ * Every test is summarized as a z-score (standard normal under the
+ * randomness hypothesis); the byte-pairs test is only reported once enough
+ * pairs have been seen for its chi-square approximation to be valid.
+ *
+ * Tallies are computed 64 bits at a time with popcount, in passes the
+ * compiler can vectorize; only whole 64-bit words are accounted for, any
+ * trailing bytes are kept until completed by a later feed.
+ *
+ * Every so many bytes, statistics are evaluated and, if any z-score
+ * exceeds the alert threshold in absolute value, the alert handler is
+ * called with the offending statistics.
+ *
+ */
+class StreamMonitor {
+  public:
+    /**
+     * A test's summary statistic
+     *
+     */
+    struct Statistic {
+      /**
+       * Test name
+       *
+       */
+      std::string name;
+
+      /**
+       * Test z-score
+       *
+       */
+      double z;
+    };
+
+    /**
+     * Alert handler, called with the statistics exceeding the threshold
+     *
+     */
+    using AlertHandler = std::function<void(std::vector<Statistic> const &)>;
+
+    /**
+     * Construct a monitor
+     *
+     * @param threshold   Absolute z-score beyond which to alert
+     * @param handler     Alert handler (nullptr to only evaluate on demand)
+     * @param lags        Autocorrelation lags to test, each in [1, 63]
+     * @param blockWords  Block size for the block-frequency test, in 64-bit words
+     * @param interval    Number of bytes between evaluations
+     * @throws std::invalid_argument  In case a lag is out of range, or the block size is 0
+     */
+    StreamMonitor(double threshold = 6.0, AlertHandler handler = nullptr, std::vector<std::size_t> const &lags = {1, 2, 3, 8, 16, 32}, std::size_t blockWords = 2, std::uint64_t interval = std::uint64_t(1) << 20);
+
+    /**
+     * Feed the given output bytes to the monitor
+     *
+     * @param data  Bytes to monitor
+     * @param n     Number of bytes to monitor
+     * @return the current monitor
+     */
+    StreamMonitor &feed(std::uint8_t const *data, std::size_t n);
+
+    /**
+     * Feed the given number of output bytes drawn from the given generator
+     *
+     * Each byte is built from 8 consecutive output bits, MSB-first.
+     *
+     * @param gen  Generator to draw from
+     * @param n    Number of bytes to draw
+     * @return the current monitor
+     */
+    StreamMonitor &feed(BitGenerator &gen, std::size_t n);
+
+    /**
+     * Evaluate every test on the output seen so far
+     *
+     * @return the tests' statistics
+     */
+    std::vector<Statistic> statistics() const noexcept;
+
+    /**
+     * Retrieve the number of bits accounted for so far
+     *
+     * @return the number of bits accounted for so far
+     */
+    std::uint64_t bits() const noexcept __attribute__((pure));
+
+    /**
+     * Discard every tally, starting afresh
+     *
+     * @return the current monitor
+     */
+    StreamMonitor &reset() noexcept;
+
+  protected:
+    /**
+     * Account for the given words (in stream order, MSB-first)
+     *
+     * @param w  Words to account for
+     * @param n  Number of words
+     */
+    void account(std::uint64_t const *w, std::size_t n) noexcept;
+
+    /**
+     * Absolute z-score beyond which to alert
+     *
+     */
+    double limit;
+
+    /**
+     * Alert handler
+     *
+     */
+    AlertHandler alert;
+
+    /**
+     * Autocorrelation lags
+     *
+     */
+    std::vector<std::size_t> lag;
+
+    /**
+     * Block size for the block-frequency test, in words
+     *
+     */
+    std::size_t block;
+
+    /**
+     * Number of bytes between evaluations
+     *
+     */
+    std::uint64_t every;
+
+    /**
+     * Bytes left until the next evaluation
+     *
+     */
+    std::uint64_t countdown;
+
+    /**
+     * Bytes pending completion of a word
+     *
+     */
+    std::uint8_t tail[8];
+
+    /**
+     * Number of bytes pending completion of a word
+     *
+     */
+    std::size_t tailLen;
+
+    /**
+     * Last word accounted for (autocorrelation and runs span word boundaries)
+     *
+     */
+    std::uint64_t prev;
+
+    /**
+     * Number of words accounted for
+     *
+     */
+    std::uint64_t words;
+
+    /**
+     * Number of one bits seen
+     *
+     */
+    std::uint64_t ones;
+
+    /**
+     * Number of transitions between consecutive bits
+     *
+     */
+    std::uint64_t transitions;
+
+    /**
+     * Number of one bits in the current block
+     *
+     */
+    std::uint64_t blockOnes;
+
+    /**
+     * Number of completed blocks
+     *
+     */
+    std::uint64_t blocks;
+
+    /**
+     * Sum of squared deviations (2 * ones - M)^2 over completed blocks of M bits
+     *
+     */
+    std::uint64_t blockDev;
+
+    /**
+     * Number of disagreeing bit pairs, per lag
+     *
+     */
+    std::vector<std::uint64_t> disagree;
+
+    /**
+     * Byte pair counts
+     *
+     */
+    std::vector<std::uint64_t> pairs;
+};
+
+
+#endif  /* STREAM_MONITOR_H__ */
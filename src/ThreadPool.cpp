@@ -0,0 +1,182 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+
+/**
+ * Construct a thread pool of the given size
+ *
+ * @param n  Number of threads to use, including the caller (0 to use the hardware concurrency)
+ */
+ThreadPool::ThreadPool(std::size_t n)
+: workers(), submitMutex(), jobMutex(), wakeUp(), jobDone(), task(nullptr), base(0), shares(), pending(0), generation(0), stopping(false) {
+  if (0 == n) {
+    n = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  }
+  shares.reset(new Share[n]);
+  for (std::size_t i = 0; i < n; i++) {
+    shares[i].range = 0;
+  }
+  for (std::size_t i = 1; i < n; i++) {
+    workers.emplace_back(&ThreadPool::work, this, i);
+  }
+}
+
+/**
+ * Destructor, joins all the worker threads
+ *
+ */
+ThreadPool::~ThreadPool() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+  for (std::thread &t : workers) {
+    t.join();
+  }
+}
+
+/**
+ * Retrieve the number of threads taking part in each job, including the caller
+ *
+ * @return the pool's size
+ */
+std::size_t ThreadPool::size() const noexcept {
+  return workers.size() + 1;
+}
+
+/**
+ * Call the given function once for every index in [0, n), in parallel
+ *
+ * The function is given the index to process, along with the number of
+ * the participant processing it (in [0, size()), the caller being 0), so
+ * that per-participant state can be kept without synchronization; no
+ * assumption on the calling order can be made, and the function must not
+ * throw.
+ *
+ * @param n  Number of indices to process
+ * @param f  Function to call for each index, as f(participant, index)
+ */
+void ThreadPool::parallelFor(std::size_t n, std::function<void(std::size_t, std::size_t)> const &f) noexcept {
+  std::lock_guard<std::mutex> submit(submitMutex);
+
+  // shares are packed as 32-bit halves, so split huge jobs into rounds
+  constexpr std::size_t maxRound = 0xffffffffu;
+  std::size_t p = size();
+
+  for (std::size_t done = 0; done < n; ) {
+    std::size_t round = std::min(n - done, maxRound);
+
+    // post the job and wake up the workers
+    {
+      std::lock_guard<std::mutex> lock(jobMutex);
+      task = &f;
+      base = done;
+      for (std::size_t i = 0; i < p; i++) {
+        std::uint64_t lo = round * i / p, hi = round * (i + 1) / p;
+        shares[i].range = (lo << 32) | hi;
+      }
+      pending = workers.size();
+      generation++;
+    }
+    wakeUp.notify_all();
+
+    // take part in the job ourselves
+    drain(0);
+
+    // wait for every worker to be done with it
+    {
+      std::unique_lock<std::mutex> lock(jobMutex);
+      jobDone.wait(lock, [this]{ return 0 == pending; });
+      task = nullptr;
+    }
+
+    done += round;
+  }
+}
+
+/**
+ * Worker thread main loop
+ *
+ * @param id  Participant number of this worker
+ */
+void ThreadPool::work(std::size_t id) noexcept {
+  std::size_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(jobMutex);
+      wakeUp.wait(lock, [this, seen]{ return stopping || seen != generation; });
+      if (stopping) { return; }
+      seen = generation;
+    }
+
+    drain(id);
+
+    {
+      std::lock_guard<std::mutex> lock(jobMutex);
+      if (0 == --pending) { jobDone.notify_one(); }
+    }
+  }
+}
+
+/**
+ * Process indices from the current job until none remain anywhere
+ *
+ * @param id  Participant number of the caller
+ */
+void ThreadPool::drain(std::size_t id) noexcept {
+  std::size_t idx;
+  do {
+    while (pop(id, idx)) {
+      (*task)(id, base + idx);
+    }
+  } while (steal(id));
+}
+
+/**
+ * Claim the next index from the given participant's own share
+ *
+ * @param id   Participant number
+ * @param idx  Where to store the claimed index
+ * @return true if an index was claimed, false if the share is exhausted
+ */
+bool ThreadPool::pop(std::size_t id, std::size_t &idx) noexcept {
+  std::uint64_t cur = shares[id].range.load();
+  while (true) {
+    std::uint64_t lo = cur >> 32, hi = cur & 0xffffffffu;
+    if (hi <= lo) { return false; }
+    if (shares[id].range.compare_exchange_weak(cur, ((lo + 1) << 32) | hi)) {
+      idx = lo;
+      return true;
+    }
+  }
+}
+
+/**
+ * Steal the back half of the largest remaining share into the given participant's share
+ *
+ * @param id  Participant number of the thief
+ * @return true if anything was stolen, false if every share is exhausted
+ */
+bool ThreadPool::steal(std::size_t id) noexcept {
+  std::size_t p = size();
+  while (true) {
+    // look for the largest remaining share
+    std::size_t victim = p;
+    std::uint64_t cur = 0, best = 0;
+    for (std::size_t i = 0; i < p; i++) {
+      std::uint64_t v = shares[i].range.load(), lo = v >> 32, hi = v & 0xffffffffu;
+      if (lo < hi && best < hi - lo) { victim = i; cur = v; best = hi - lo; }
+    }
+    if (p == victim) { return false; }
+
+    // try to take its back half, retry from scratch if it changed meanwhile
+    std::uint64_t lo = cur >> 32, hi = cur & 0xffffffffu, mid = lo + (hi - lo) / 2;
+    if (shares[victim].range.compare_exchange_strong(cur, (lo << 32) | mid)) {
+      shares[id].range = (mid << 32) | hi;
+      return true;
+    }
+  }
+}
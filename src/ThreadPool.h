@@ -0,0 +1,197 @@
+#ifndef THREAD_POOL_H__
+#define THREAD_POOL_H__
+
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Fixed-size thread pool for data-parallel loops
+ *
+ * The pool keeps its worker threads parked between jobs, the calling thread
+ * always participates in the job it submits, so that a pool of size 1 spawns
+ * no threads at all and runs everything inline.
+ *
+ * Jobs are scheduled by work stealing: each participant starts off with an
+ * equal contiguous share of the indices and consumes it front to back, once
+ * its share is exhausted it steals the back half of the largest remaining
+ * share.
+ *
+ */
+class ThreadPool {
+  public:
+    /**
+     * Construct a thread pool of the given size
+     *
+     * @param n  Number of threads to use, including the caller (0 to use the hardware concurrency)
+     */
+    ThreadPool(std::size_t n = 0);
+
+    /**
+     * Deleted copy constructor
+     *
+     */
+    ThreadPool(ThreadPool const &) = delete;
+
+    /**
+     * Deleted copy assignment
+     *
+     */
+    ThreadPool &operator=(ThreadPool const &) = delete;
+
+    /**
+     * Destructor, joins all the worker threads
+     *
+     */
+    ~ThreadPool() noexcept;
+
+    /**
+     * Retrieve the number of threads taking part in each job, including the caller
+     *
+     * @return the pool's size
+     */
+    std::size_t size() const noexcept __attribute__((pure));
+
+    /**
+     * Call the given function once for every index in [0, n), in parallel
+     *
+     * The function is given the index to process, along with the number of
+     * the participant processing it (in [0, size()), the caller being 0), so
+     * that per-participant state can be kept without synchronization; no
+     * assumption on the calling order can be made, and the function must not
+     * throw.
+     *
+     * @param n  Number of indices to process
+     * @param f  Function to call for each index, as f(participant, index)
+     */
+    void parallelFor(std::size_t n, std::function<void(std::size_t, std::size_t)> const &f) noexcept;
+
+  protected:
+    /**
+     * Share of indices owned by a participant, padded to a cache line
+     *
+     * The share is packed as begin (high 32 bits) and end (low 32 bits) so
+     * that both the owner and thieves may update it with a single CAS.
+     *
+     */
+    struct Share {
+      /**
+       * Packed [begin, end) range
+       *
+       */
+      std::atomic<std::uint64_t> range;
+
+      /**
+       * Padding up to a typical cache line, to avoid false sharing
+       *
+       */
+      char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    /**
+     * Worker thread main loop
+     *
+     * @param id  Participant number of this worker
+     */
+    void work(std::size_t id) noexcept;
+
+    /**
+     * Process indices from the current job until none remain anywhere
+     *
+     * @param id  Participant number of the caller
+     */
+    void drain(std::size_t id) noexcept;
+
+    /**
+     * Claim the next index from the given participant's own share
+     *
+     * @param id   Participant number
+     * @param idx  Where to store the claimed index
+     * @return true if an index was claimed, false if the share is exhausted
+     */
+    bool pop(std::size_t id, std::size_t &idx) noexcept;
+
+    /**
+     * Steal the back half of the largest remaining share into the given participant's share
+     *
+     * @param id  Participant number of the thief
+     * @return true if anything was stolen, false if every share is exhausted
+     */
+    bool steal(std::size_t id) noexcept;
+
+    /**
+     * Worker threads
+     *
+     */
+    std::vector<std::thread> workers;
+
+    /**
+     * Mutex serializing concurrent parallelFor calls
+     *
+     */
+    std::mutex submitMutex;
+
+    /**
+     * Mutex protecting the job state
+     *
+     */
+    std::mutex jobMutex;
+
+    /**
+     * Condition variable used to wake up the workers
+     *
+     */
+    std::condition_variable wakeUp;
+
+    /**
+     * Condition variable used to signal job completion
+     *
+     */
+    std::condition_variable jobDone;
+
+    /**
+     * Function being applied by the current job
+     *
+     */
+    std::function<void(std::size_t, std::size_t)> const *task;
+
+    /**
+     * Offset added to every index in the current job (jobs are split into 32-bit sized rounds)
+     *
+     */
+    std::size_t base;
+
+    /**
+     * Per-participant shares of the current job
+     *
+     */
+    std::unique_ptr<Share[]> shares;
+
+    /**
+     * Number of workers still busy with the current job
+     *
+     */
+    std::size_t pending;
+
+    /**
+     * Job generation counter, used by the workers to detect new jobs
+     *
+     */
+    std::size_t generation;
+
+    /**
+     * Whether the pool is shutting down
+     *
+     */
+    bool stopping;
+};
+
+
+#endif  /* THREAD_POOL_H__ */
@@ -1,5 +1,8 @@
 #include "Xsg.h"
 
+#include <memory>
+#include <utility>
+
 #include "Random.h"
 
 
@@ -95,6 +98,75 @@ namespace {
 }
 
 
+namespace {
+  /**
+   * Build the canonical bootstrap XSG
+   *
+   * The canonical bootstrap uses the first prefixes of Pi as LFSR states,
+   * and successive mother multipliers, small primes as offsets, and
+   * successive initial values for the ICGs; it is fully blended before
+   * being returned.
+   *
+   * @return the canonical bootstrap XSG
+   */
+  Xsg512 buildCanonicalBoot() noexcept {
+    return Xsg512(
+      Lfsr<521>(hexPi521, hexGen521), false,
+      Lfsr<523>(hexPi523, hexGen523),
+      Icg::deriveFromMother(523, mothers523[ 0],   2,  0),
+      Icg::deriveFromMother(523, mothers523[ 1],   3,  1),
+      Icg::deriveFromMother(523, mothers523[ 2],   5,  2),
+      Icg::deriveFromMother(523, mothers523[ 3],   7,  3),
+      Icg::deriveFromMother(523, mothers523[ 4],  11,  4),
+      Icg::deriveFromMother(523, mothers523[ 5],  13,  5),
+      Icg::deriveFromMother(523, mothers523[ 6],  17,  6),
+      Icg::deriveFromMother(523, mothers523[ 7],  19,  7),
+      Icg::deriveFromMother(523, mothers523[ 8],  22,  8),
+      Lfsr<541>(hexPi541, hexGen541),
+      Icg::deriveFromMother(541, mothers541[ 9],  31,  9),
+      Icg::deriveFromMother(541, mothers541[10],  37, 10),
+      Icg::deriveFromMother(541, mothers541[11],  41, 11),
+      Icg::deriveFromMother(541, mothers541[12],  43, 12),
+      Icg::deriveFromMother(541, mothers541[13],  47, 13),
+      Icg::deriveFromMother(541, mothers541[14],  53, 14),
+      Icg::deriveFromMother(541, mothers541[15],  59, 15),
+      Icg::deriveFromMother(541, mothers541[16],  61, 16),
+      Icg::deriveFromMother(541, mothers541[17],  67, 17),
+      Lfsr<547>(hexPi547, hexGen547),
+      Icg::deriveFromMother(547, mothers547[18],  71, 18),
+      Icg::deriveFromMother(547, mothers547[19],  73, 19),
+      Icg::deriveFromMother(547, mothers547[20],  79, 20),
+      Icg::deriveFromMother(547, mothers547[21],  83, 21),
+      Icg::deriveFromMother(547, mothers547[22],  89, 22),
+      Icg::deriveFromMother(547, mothers547[23],  97, 23),
+      Icg::deriveFromMother(547, mothers547[24], 101, 24),
+      Icg::deriveFromMother(547, mothers547[25], 103, 25),
+      Icg::deriveFromMother(547, mothers547[26], 107, 26),
+      Lfsr<557>(hexPi557, hexGen557),
+      Icg::deriveFromMother(557, mothers557[27], 109, 27),
+      Icg::deriveFromMother(557, mothers557[28], 113, 28),
+      Icg::deriveFromMother(557, mothers557[29], 127, 29),
+      Icg::deriveFromMother(557, mothers557[30], 131, 30),
+      Icg::deriveFromMother(557, mothers557[31], 137, 31),
+      Icg::deriveFromMother(557, mothers557[32], 139, 32),
+      Icg::deriveFromMother(557, mothers557[33], 149, 33),
+      Icg::deriveFromMother(557, mothers557[34], 151, 34),
+      Icg::deriveFromMother(557, mothers557[35], 157, 35)
+    ).blend(4, true);
+  }
+
+  /**
+   * Retrieve the canonical bootstrap XSG, building it on first use
+   *
+   * @return the canonical bootstrap XSG
+   */
+  Xsg512 const &canonicalBoot() noexcept {
+    static Xsg512 const boot = buildCanonicalBoot();
+    return boot;
+  }
+}
+
+
 /**
  * Return a distilled XSG from a key
  *
@@ -112,52 +184,14 @@ namespace {
  * @return the created bootstrap XSG
  */
 Xsg512 distillXsg(std::string key) noexcept {
-  Xsg512 boot = Xsg512(
-    Lfsr<521>(hexPi521, hexGen521), false,
-    Lfsr<523>(hexPi523, hexGen523),
-    Icg::deriveFromMother(523, mothers523[ 0],   2,  0),
-    Icg::deriveFromMother(523, mothers523[ 1],   3,  1),
-    Icg::deriveFromMother(523, mothers523[ 2],   5,  2),
-    Icg::deriveFromMother(523, mothers523[ 3],   7,  3),
-    Icg::deriveFromMother(523, mothers523[ 4],  11,  4),
-    Icg::deriveFromMother(523, mothers523[ 5],  13,  5),
-    Icg::deriveFromMother(523, mothers523[ 6],  17,  6),
-    Icg::deriveFromMother(523, mothers523[ 7],  19,  7),
-    Icg::deriveFromMother(523, mothers523[ 8],  22,  8),
-    Lfsr<541>(hexPi541, hexGen541),
-    Icg::deriveFromMother(541, mothers541[ 9],  31,  9),
-    Icg::deriveFromMother(541, mothers541[10],  37, 10),
-    Icg::deriveFromMother(541, mothers541[11],  41, 11),
-    Icg::deriveFromMother(541, mothers541[12],  43, 12),
-    Icg::deriveFromMother(541, mothers541[13],  47, 13),
-    Icg::deriveFromMother(541, mothers541[14],  53, 14),
-    Icg::deriveFromMother(541, mothers541[15],  59, 15),
-    Icg::deriveFromMother(541, mothers541[16],  61, 16),
-    Icg::deriveFromMother(541, mothers541[17],  67, 17),
-    Lfsr<547>(hexPi547, hexGen547),
-    Icg::deriveFromMother(547, mothers547[18],  71, 18),
-    Icg::deriveFromMother(547, mothers547[19],  73, 19),
-    Icg::deriveFromMother(547, mothers547[20],  79, 20),
-    Icg::deriveFromMother(547, mothers547[21],  83, 21),
-    Icg::deriveFromMother(547, mothers547[22],  89, 22),
-    Icg::deriveFromMother(547, mothers547[23],  97, 23),
-    Icg::deriveFromMother(547, mothers547[24], 101, 24),
-    Icg::deriveFromMother(547, mothers547[25], 103, 25),
-    Icg::deriveFromMother(547, mothers547[26], 107, 26),
-    Lfsr<557>(hexPi557, hexGen557),
-    Icg::deriveFromMother(557, mothers557[27], 109, 27),
-    Icg::deriveFromMother(557, mothers557[28], 113, 28),
-    Icg::deriveFromMother(557, mothers557[29], 127, 29),
-    Icg::deriveFromMother(557, mothers557[30], 131, 30),
-    Icg::deriveFromMother(557, mothers557[31], 137, 31),
-    Icg::deriveFromMother(557, mothers557[32], 139, 32),
-    Icg::deriveFromMother(557, mothers557[33], 149, 33),
-    Icg::deriveFromMother(557, mothers557[34], 151, 34),
-    Icg::deriveFromMother(557, mothers557[35], 157, 35)
-  ).blend(4, true);
+  Xsg512 boot = canonicalBoot();
   return distillXsg(key, boot);
 }
 Xsg512 distillXsg(std::string key, Xsg512 &boot) noexcept {
+#ifdef XSG_STATS
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+#endif
+
   // inject key
   boot.inject(key, 4);
 
@@ -211,7 +245,7 @@ Xsg512 distillXsg(std::string key, Xsg512 &boot) noexcept {
   std::uint64_t is3l2 = randRange(boot, 557), is3m2 = randRange(boot, 557), is3h2 = randRange(boot, 557);
 
   // build final XSG
-  return Xsg512(
+  Xsg512 ret = Xsg512(
     Lfsr<521>(m,  hexGen521), false,
     Lfsr<523>(s0, hexGen523),
     Icg::deriveFromMother(523, as0l1, cs0l1, is0l1), Icg::deriveFromMother(523, as0m1, cs0m1, is0m1), Icg::deriveFromMother(523, as0h1, cs0h1, is0h1),
@@ -229,7 +263,48 @@ Xsg512 distillXsg(std::string key, Xsg512 &boot) noexcept {
     Icg::deriveFromMother(557, as3l0, cs3l0, is3l0), Icg::deriveFromMother(557, as3m0, cs3m0, is3m0), Icg::deriveFromMother(557, as3h0, cs3h0, is3h0),
     Icg::deriveFromMother(557, as3l1, cs3l1, is3l1), Icg::deriveFromMother(557, as3m1, cs3m1, is3m1), Icg::deriveFromMother(557, as3h1, cs3h1, is3h1),
     Icg::deriveFromMother(557, as3l2, cs3l2, is3l2), Icg::deriveFromMother(557, as3m2, cs3m2, is3m2), Icg::deriveFromMother(557, as3h2, cs3h2, is3h2)
-  ).blend(4, true);
+  ).blend(4, true).saveKeyedState();
+  XSG_STAT(ret.addDistillTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)));
+  return ret;
+}
+
+
+/**
+ * Distill many XSGs at once, in parallel
+ *
+ * Every key is distilled from its own copy of the canonical bootstrap XSG,
+ * so that the results are exactly those of calling distillXsg() on each
+ * key in turn, regardless of the number of threads used.
+ *
+ * @param keys     The keys to use for distilling
+ * @param pool     Thread pool to distribute the work over (a fresh one of hardware size if none given)
+ * @param timings  If not null, filled with the time spent distilling each key
+ * @return the distilled XSGs, in the same order as the given keys
+ */
+std::vector<Xsg512> distillMany(std::vector<std::string> const &keys, std::vector<std::chrono::nanoseconds> *timings) noexcept {
+  ThreadPool pool;
+  return distillMany(keys, pool, timings);
 }
+std::vector<Xsg512> distillMany(std::vector<std::string> const &keys, ThreadPool &pool, std::vector<std::chrono::nanoseconds> *timings) noexcept {
+  // results are built out of order, so keep them in individual slots first
+  std::vector<std::unique_ptr<Xsg512>> slots(keys.size());
+  if (nullptr != timings) { timings->assign(keys.size(), std::chrono::nanoseconds::zero()); }
 
+  // make sure the shared bootstrap is built before fanning out
+  Xsg512 const &shared = canonicalBoot();
 
+  pool.parallelFor(keys.size(), [&](std::size_t, std::size_t i) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Xsg512 boot = shared;
+    slots[i].reset(new Xsg512(distillXsg(keys[i], boot)));
+    if (nullptr != timings) { (*timings)[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start); }
+  });
+
+  std::vector<Xsg512> ret;
+  ret.reserve(keys.size());
+  for (std::unique_ptr<Xsg512> &slot : slots) {
+    ret.push_back(std::move(*slot));
+  }
+
+  return ret;
+}
@@ -6,11 +6,17 @@
 #include <string>
 #include <cstdint>
 #include <new>
+#include <vector>
+#include <chrono>
+#include <array>
+#include <bitset>
 
 #include "BitGenerator.h"
 #include "Hasher.h"
 #include "Lfsr.h"
 #include "Icg.h"
+#include "ThreadPool.h"
+#include "XsgStats.h"
 
 
 /**
@@ -27,7 +33,65 @@ class Xsg : public BitGenerator, public Hasher {
   // Ensure the master LFSR is at least odd
   static_assert(1 == M % 2, "The master LFSR size should be an odd prime");
 
+  /**
+   * Multi-lane XSGs drive their lanes through this XSG's master and ICGs
+   *
+   */
+  template <std::size_t, std::size_t, std::size_t, std::size_t, std::size_t, std::size_t>
+  friend class XsgLanes;
+
   public:
+    /**
+     * Extendable-output reader over a finalized XSG
+     *
+     * Readers are obtained through finalizeXof() and squeeze output bytes
+     * from the XSG they were obtained from, in as many chunks as desired;
+     * the XSG must outlive the reader.
+     *
+     */
+    class XofReader {
+      public:
+        /**
+         * Construct a reader squeezing from the given XSG
+         *
+         * @param x  XSG to squeeze from
+         */
+        explicit XofReader(Xsg &x) noexcept;
+
+        /**
+         * Squeeze the given number of output bytes into the given buffer
+         *
+         * Each byte is built from 8 consecutive output bits, MSB-first;
+         * squeezing n bytes and then m bytes yields exactly the same output as
+         * squeezing n + m bytes at once.
+         *
+         * @param out  Buffer to write the bytes to
+         * @param n    Number of bytes to squeeze
+         * @return the current reader
+         */
+        XofReader &read(std::uint8_t *out, std::size_t n) noexcept;
+
+        /**
+         * Retrieve the number of bytes squeezed so far
+         *
+         * @return the number of bytes squeezed so far
+         */
+        std::uint64_t squeezed() const noexcept __attribute__((pure));
+
+      protected:
+        /**
+         * XSG to squeeze from
+         *
+         */
+        Xsg *xsg;
+
+        /**
+         * Number of bytes squeezed so far
+         *
+         */
+        std::uint64_t count;
+    };
+
     /**
      * Virtual placement clone
      *
@@ -156,6 +220,14 @@ class Xsg : public BitGenerator, public Hasher {
      */
     virtual bool next() noexcept override;
 
+    /**
+     * Return the given number of output bits, packed MSB-first into a word
+     *
+     * @param n  Number of bits to generate (at most 64)
+     * @return the generated bits
+     */
+    virtual std::uint64_t nextBits(std::size_t n) noexcept override;
+
     /**
      * Blend the slaves and, optionally, the master as well
      *
@@ -208,7 +280,18 @@ class Xsg : public BitGenerator, public Hasher {
      * @param w    Width of the hash to be generated
      * @return the generated hash, as an hexadecimal string
      */
-    virtual std::string hash(std::string s, std::size_t w) noexcept override;
+    virtual std::string hash(std::string const &s, std::size_t w) noexcept override;
+
+    /**
+     * Generate a variable length hash into the given buffer
+     *
+     * This performs no heap allocation for hashes up to 4096 bits wide.
+     *
+     * @param s    String to hash
+     * @param w    Width of the hash to be generated
+     * @param out  Buffer to write the (w + 3) / 4 hexadecimal digits to (no terminator is added)
+     */
+    virtual void hash(std::string const &s, std::size_t w, char *out) noexcept override;
 
     /**
      * Add the given string to an ongoing hashing operation
@@ -216,7 +299,7 @@ class Xsg : public BitGenerator, public Hasher {
      * @param s  String to add
      * @return the current XSG
      */
-    virtual Xsg &hashAdd(std::string s) noexcept override;
+    virtual Xsg &hashAdd(std::string const &s) noexcept override;
 
     /**
      * Return a hash for the elements added so far, but leave the hashing context untouched
@@ -234,7 +317,166 @@ class Xsg : public BitGenerator, public Hasher {
      */
     virtual std::string hashFinal(std::size_t w) noexcept override;
 
+    /**
+     * Finalize the hashing operation and write the calculated hash into the given buffer
+     *
+     * This performs no heap allocation for hashes up to 4096 bits wide.
+     *
+     * @param w    Hash length
+     * @param out  Buffer to write the (w + 3) / 4 hexadecimal digits to (no terminator is added)
+     */
+    virtual void hashFinal(std::size_t w, char *out) noexcept override;
+
+    /**
+     * Finalize the hashing operation in extendable-output mode
+     *
+     * Finalizing in extendable-output mode entails:
+     *  - blending,
+     *  - blending (in lieu of the Elias-Omega coding for the width, ie. the
+     *    empty code of 0, which never collides with that of a positive width),
+     *  - sealing with a fixed-width pseudohash and blending,
+     * after which output may be squeezed indefinitely through the returned
+     * reader, using constant memory and without committing to any length.
+     *
+     * @return a reader squeezing the hash's output
+     */
+    XofReader finalizeXof() noexcept;
+
+    /**
+     * Record the current state as the keyed state to return to upon reset()
+     *
+     * Only the LFSR registers and ICG states are recorded, generators,
+     * parameters, and tables are never modified by stepping.
+     *
+     * @return the current XSG
+     */
+    virtual Xsg &saveKeyedState() noexcept override;
+
+    /**
+     * Return to the last recorded keyed state, discarding any ongoing hashing operation
+     *
+     * If no state was ever recorded, the state upon construction is used.
+     *
+     * @return the current XSG
+     */
+    virtual Xsg &reset() noexcept override;
+
+    /**
+     * Retrieve the hot-path statistics collected so far
+     *
+     * Statistics are only collected when compiling with XSG_STATS defined.
+     *
+     * @return the statistics collected (all-zero if disabled)
+     */
+    XsgStats stats() const noexcept;
+
+    /**
+     * Clear the hot-path statistics collected so far
+     *
+     * @return the current XSG
+     */
+    Xsg &clearStats() noexcept;
+
+    /**
+     * Account the given time as spent distilling this XSG
+     *
+     * @param t  Time spent
+     * @return the current XSG
+     */
+    Xsg &addDistillTime(std::chrono::nanoseconds t) noexcept;
+
   protected:
+    /**
+     * Snapshot of every mutable register in the XSG
+     *
+     */
+    struct Registers {
+      /**
+       * Master LFSR state
+       *
+       */
+      std::bitset<M> master;
+
+      /**
+       * Slave 0 LFSR state
+       *
+       */
+      std::bitset<S0> slave0;
+
+      /**
+       * Slave 1 LFSR state
+       *
+       */
+      std::bitset<S1> slave1;
+
+      /**
+       * Slave 2 LFSR state
+       *
+       */
+      std::bitset<S2> slave2;
+
+      /**
+       * Slave 3 LFSR state
+       *
+       */
+      std::bitset<S3> slave3;
+
+      /**
+       * ICG states, in the order given by icgs()
+       *
+       */
+      std::array<std::uint64_t, 36> icg;
+    };
+
+    /**
+     * Retrieve pointers to all the ICGs, in declaration order
+     *
+     * @return an array of pointers to every ICG
+     */
+    std::array<Icg *, 36> icgs() noexcept;
+
+    /**
+     * Capture every mutable register
+     *
+     * @return the captured registers
+     */
+    Registers capture() noexcept;
+
+    /**
+     * Width of the pseudohash used to seal the state in extendable-output mode
+     *
+     */
+    static constexpr std::size_t xofSealWidth = 512;
+
+    /**
+     * Feed the given bytes, MSB-first, into the XSG
+     *
+     * This is equivalent to calling step() for every bit of the given bytes,
+     * but processes 64 bits at a time: since the master evolves independently
+     * of the data and the slaves, the slave selectors for a whole word are
+     * computed upfront, and data bits are shifted out of a single word.
+     *
+     * @param data  Bytes to feed
+     * @param n     Number of bytes to feed
+     */
+    void absorb(char const *data, std::size_t n) noexcept;
+
+    /**
+     * Advance the master for the given number of steps and record each step's slave selector
+     *
+     * @param sel  Where to store the selectors
+     * @param n    Number of steps to precompute
+     */
+    void selectors(std::uint8_t *sel, std::size_t n) noexcept;
+
+    /**
+     * Step the given slave as needed, XORing the given value in
+     *
+     * @param sel  Slave to step
+     * @param val  Value to XOR in
+     */
+    void stepSlave(std::uint8_t sel, bool val) noexcept;
+
     /**
      * Step Slave 0 as needed, XORing the given value in
      *
@@ -530,6 +772,20 @@ class Xsg : public BitGenerator, public Hasher {
      *
      */
     bool includeMaster;
+
+    /**
+     * Registers to restore upon reset()
+     *
+     */
+    Registers keyed;
+
+#ifdef XSG_STATS
+    /**
+     * Hot-path statistics
+     *
+     */
+    XsgStats statistics;
+#endif
 };
 
 /**
@@ -557,6 +813,21 @@ using Xsg512 = Xsg<521, 523, 541, 547, 557>;
 Xsg512 distillXsg(std::string key) noexcept;
 Xsg512 distillXsg(std::string key, Xsg512 &boot) noexcept;
 
+/**
+ * Distill many XSGs at once, in parallel
+ *
+ * Every key is distilled from its own copy of the canonical bootstrap XSG,
+ * so that the results are exactly those of calling distillXsg() on each
+ * key in turn, regardless of the number of threads used.
+ *
+ * @param keys     The keys to use for distilling
+ * @param pool     Thread pool to distribute the work over (a fresh one of hardware size if none given)
+ * @param timings  If not null, filled with the time spent distilling each key
+ * @return the distilled XSGs, in the same order as the given keys
+ */
+std::vector<Xsg512> distillMany(std::vector<std::string> const &keys, std::vector<std::chrono::nanoseconds> *timings = nullptr) noexcept;
+std::vector<Xsg512> distillMany(std::vector<std::string> const &keys, ThreadPool &pool, std::vector<std::chrono::nanoseconds> *timings = nullptr) noexcept;
+
 
 #include "Xsg.hpp"
 
@@ -16,53 +16,161 @@ namespace {
   constexpr char hex[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
 
   /**
-   * Turn a bool vector into an hexadecimal strings
+   * Fixed-capacity bit buffer
+   *
+   * Bits are packed into 64-bit words held inline, only hashes wider than
+   * the inline capacity spill over to the heap.
    *
-   * @param bv  Bool vector to transform
-   * @return the hexadecimal string equivalent of the given bool vector
    */
-  std::string boolVector2hex(std::vector<bool> bv) noexcept {
-    std::string h;
-
-    while (!bv.empty()) {
-      std::size_t d = 0;
-      switch (bv.size()) {
-        default: d = (d << 1) | bv.back(); bv.pop_back();
-        case 3:  d = (d << 1) | bv.back(); bv.pop_back();
-        case 2:  d = (d << 1) | bv.back(); bv.pop_back();
-        case 1:  d = (d << 1) | bv.back(); bv.pop_back();
-                 h = hex[d] + h;
-        case 0:  break;
+  class BitBuffer {
+    public:
+      /**
+       * Number of words held inline
+       *
+       */
+      static constexpr std::size_t inlineWords = 64;
+
+      /**
+       * Construct a cleared bit buffer able to hold the given number of bits
+       *
+       * @param w  Number of bits to hold
+       */
+      explicit BitBuffer(std::size_t w) : local(), spill((w + 63) / 64 > inlineWords ? (w + 63) / 64 : 0), words(spill.empty() ? local.data() : spill.data()) {}
+
+      /**
+       * Deleted copy constructor (the words pointer may point into the object itself)
+       *
+       */
+      BitBuffer(BitBuffer const &) = delete;
+
+      /**
+       * Deleted copy assignment
+       *
+       */
+      BitBuffer &operator=(BitBuffer const &) = delete;
+
+      /**
+       * Set the given bit to the given value
+       *
+       * @param i    Bit index
+       * @param val  Value to set
+       */
+      void set(std::size_t i, bool val) noexcept {
+        std::uint64_t mask = std::uint64_t(1) << (i % 64);
+        words[i / 64] = val ? (words[i / 64] | mask) : (words[i / 64] & ~mask);
       }
-    }
 
-    return h;
+      /**
+       * Get the given bit's value
+       *
+       * @param i  Bit index
+       * @return the bit's value
+       */
+      bool get(std::size_t i) const noexcept {
+        return (words[i / 64] >> (i % 64)) & 1u;
+      }
+
+    protected:
+      /**
+       * Inline storage
+       *
+       */
+      std::array<std::uint64_t, inlineWords> local;
+
+      /**
+       * Heap storage, only used for buffers exceeding the inline capacity
+       *
+       */
+      std::vector<std::uint64_t> spill;
+
+      /**
+       * Storage in use
+       *
+       */
+      std::uint64_t *words;
+  };
+
+  /**
+   * Write the hexadecimal representation of the first w bits of a bit buffer
+   *
+   * Hexadecimal digits are laid out so that the last bit is the most
+   * significant bit of the last digit, if w is not a multiple of 4, the first
+   * digit holds the remaining (fewer) bits.
+   *
+   * Exactly (w + 3) / 4 characters are written, no terminator is added.
+   *
+   * @param bb   Bit buffer to transform
+   * @param w    Number of bits to transform
+   * @param out  Where to write the hexadecimal digits to
+   */
+  void bitBuffer2hex(BitBuffer const &bb, std::size_t w, char *out) noexcept {
+    std::size_t len = (w + 3) / 4;
+    for (std::size_t k = 0; k < len; k++) {
+      // digit k (from the right) holds bits [w - 4k - 4, w - 4k), MSB being the highest one
+      std::size_t hi = w - 4 * k, lo = hi < 4 ? 0 : hi - 4, d = 0;
+      for (std::size_t i = hi; i > lo; i--) { d = (d << 1) | bb.get(i - 1); }
+      out[len - 1 - k] = hex[d];
+    }
   }
 
+  /**
+   * Elias-Omega code, as a fixed-size bit array
+   *
+   * The longest code for a 64-bit number is well below 128 bits long.
+   *
+   */
+  struct EliasOmega {
+    /**
+     * Code bits, in feeding order
+     *
+     */
+    std::array<std::uint64_t, 2> words;
+
+    /**
+     * Code length
+     *
+     */
+    std::size_t size;
+
+    /**
+     * Get the given code bit
+     *
+     * @param i  Bit index (in feeding order)
+     * @return the bit's value
+     */
+    bool operator[](std::size_t i) const noexcept {
+      return (words[i / 64] >> (i % 64)) & 1u;
+    }
+  };
+
   /**
    * Calculate the Elias-Omega code for the given number.
    *
    * If the given number is 0, the Elias-Omega code is empty.
    * See https://en.wikipedia.org/wiki/Elias_omega_coding.
    *
+   * The code is built right to left (ie. terminating 0 first, then each
+   * group LSB-first), so its length is calculated beforehand to place every
+   * bit directly where it belongs.
+   *
    * @param n  Number to encode
-   * @return the Elias-Omega coding as a bit vector
+   * @return the Elias-Omega coding as a fixed-size bit array
    */
-  std::vector<bool> eliasOmegaCode(std::uint64_t n) noexcept {
-    std::vector<bool> ret;
-    std::uint64_t l;
+  EliasOmega eliasOmegaCode(std::uint64_t n) noexcept {
+    EliasOmega ret = {{{0, 0}}, 0};
     if (n) {
-      ret.push_back(false);
-      while (n > 1) {
-        l = 0;
-        while (n) {
-          ret.push_back(n % 2);
-          n >>= 1;
-          l++;
-        }
-        n = l - 1;
+      // calculate the code's length
+      std::size_t len = 1;
+      for (std::uint64_t m = n, l; m > 1; m = l - 1) {
+        l = 0; for (std::uint64_t t = m; t; t >>= 1) { l++; }
+        len += l;
       }
-      std::reverse(ret.begin(), ret.end());
+      // place each group's bits, the terminating 0 is already in place
+      std::size_t j = len - 1;
+      for (std::uint64_t m = n, l; m > 1; m = l - 1) {
+        l = 0; for (std::uint64_t t = m; t; t >>= 1) { j--; l++; ret.words[j / 64] |= (t % 2) << (j % 64); }
+      }
+      ret.size = len;
     }
     return ret;
   }
@@ -186,7 +294,11 @@ Xsg<M, S0, S1, S2, S3>::Xsg(Lfsr<M> m, bool im,
   slave1low0(s1l0), slave1mid0(s1m0), slave1high0(s1h0), slave1low2(s1l2), slave1mid2(s1m2), slave1high2(s1h2), slave1low3(s1l3), slave1mid3(s1m3), slave1high3(s1h3),
   slave2low0(s2l0), slave2mid0(s2m0), slave2high0(s2h0), slave2low1(s2l1), slave2mid1(s2m1), slave2high1(s2h1), slave2low3(s2l3), slave2mid3(s2m3), slave2high3(s2h3),
   slave3low0(s3l0), slave3mid0(s3m0), slave3high0(s3h0), slave3low1(s3l1), slave3mid1(s3m1), slave3high1(s3h1), slave3low2(s3l2), slave3mid2(s3m2), slave3high2(s3h2),
-  includeMaster(im)
+  includeMaster(im),
+  keyed(capture())
+#ifdef XSG_STATS
+  , statistics()
+#endif
 {
   if (S0 != s0l1.modulus()) { throw new std::invalid_argument("Modulus mismatch for S0L1"); }
   if (S0 != s0m1.modulus()) { throw new std::invalid_argument("Modulus mismatch for S0M1"); }
@@ -246,14 +358,9 @@ constexpr bool Xsg<M, S0, S1, S2, S3>::get() const noexcept {
  */
 template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
 Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::step(bool val) noexcept {
-  switch (master.next() + 2 * master.next()) {
-    case 0: step0(val); break;
-    case 1: step1(val); break;
-    case 2: step2(val); break;
-    case 3: step3(val); break;
-    default:            break;
-  }
-  if (includeMaster) { master.step(); }
+  std::uint8_t sel;
+  selectors(&sel, 1);
+  stepSlave(sel, val);
   return *this;
 }
 
@@ -265,6 +372,7 @@ Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::step(bool val) noexcept {
  */
 template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
 bool Xsg<M, S0, S1, S2, S3>::next(bool val) noexcept {
+  XSG_STAT(statistics.outputBits++);
   return step(val).get();
 }
 
@@ -278,6 +386,19 @@ bool Xsg<M, S0, S1, S2, S3>::next() noexcept {
   return next(false);
 }
 
+/**
+ * Return the given number of output bits, packed MSB-first into a word
+ *
+ * @param n  Number of bits to generate (at most 64)
+ * @return the generated bits
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+std::uint64_t Xsg<M, S0, S1, S2, S3>::nextBits(std::size_t n) noexcept {
+  std::uint64_t ret = 0;
+  for (std::size_t i = 0; i < n; i++) { ret = (ret << 1) | next(false); }
+  return ret;
+}
+
 /**
  * Blend the slaves and, optionally, the master as well
  *
@@ -293,6 +414,8 @@ bool Xsg<M, S0, S1, S2, S3>::next() noexcept {
  */
 template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
 Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::blend(std::size_t additionalRounds, bool im) {
+  XSG_STAT(statistics.blends++);
+  XSG_STAT(statistics.blendSteps += (additionalRounds + 1) * ((includeMaster || im ? M : 0) + S0 + S1 + S2 + S3));
   if (includeMaster || im) { for (std::size_t i = 0; i < (additionalRounds + 1) * M; i++) { master.step(); } }
   for (std::size_t i = 0; i < (additionalRounds + 1) * S0; i++) { slave0.step(); }
   for (std::size_t i = 0; i < (additionalRounds + 1) * S1; i++) { slave1.step(); }
@@ -321,15 +444,16 @@ Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::blend(std::size_t additionalRoun
 template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
 Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::inject(std::string key, std::size_t additionalRounds) noexcept {
   // feed each bit in the key
-  for (char c : key) { for (std::size_t i = 0; i < 8; i++) { step((c >> (7 - i)) % 2); } }
+  absorb(key.data(), key.size());
   // blend
   blend(1, true);
   // feed each bit of the Elias-Omega coding of the key's length
-  for (bool b : eliasOmegaCode(key.length())) { step(b); }
+  EliasOmega eo = eliasOmegaCode(key.length());
+  for (std::size_t i = 0; i < eo.size; i++) { step(eo[i]); }
   // blend
   blend(1, true);
   // feed each bit in the key
-  for (char c : key) { for (std::size_t i = 0; i < 8; i++) { step((c >> (7 - i)) % 2); } }
+  absorb(key.data(), key.size());
   // blend
   blend(additionalRounds, true);
 
@@ -355,10 +479,24 @@ Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::inject(std::string key, std::siz
  * @return the generated hash, as an hexadecimal string
  */
 template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
-std::string Xsg<M, S0, S1, S2, S3>::hash(std::string s, std::size_t w) noexcept {
+std::string Xsg<M, S0, S1, S2, S3>::hash(std::string const &s, std::size_t w) noexcept {
   return hashAdd(s).hashFinal(w);
 }
 
+/**
+ * Generate a variable length hash into the given buffer
+ *
+ * This performs no heap allocation for hashes up to 4096 bits wide.
+ *
+ * @param s    String to hash
+ * @param w    Width of the hash to be generated
+ * @param out  Buffer to write the (w + 3) / 4 hexadecimal digits to (no terminator is added)
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+void Xsg<M, S0, S1, S2, S3>::hash(std::string const &s, std::size_t w, char *out) noexcept {
+  hashAdd(s).hashFinal(w, out);
+}
+
 /**
  * Add the given string to an ongoing hashing operation
  *
@@ -366,9 +504,10 @@ std::string Xsg<M, S0, S1, S2, S3>::hash(std::string s, std::size_t w) noexcept
  * @return the current XSG
  */
 template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
-Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::hashAdd(std::string s) noexcept {
+Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::hashAdd(std::string const &s) noexcept {
+  XSG_STAT_TIMER(statistics.outputTime);
   // feed each bit in the string
-  for (char c : s) { for (std::size_t i = 0; i < 8; i++) { step((c >> (7 - i)) % 2); } }
+  absorb(s.data(), s.size());
   return *this;
 }
 
@@ -392,22 +531,268 @@ std::string Xsg<M, S0, S1, S2, S3>::hashPartial(std::size_t w) const noexcept {
  */
 template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
 std::string Xsg<M, S0, S1, S2, S3>::hashFinal(std::size_t w) noexcept {
+  std::string h((w + 3) / 4, '0');
+  hashFinal(w, &h[0]);
+  return h;
+}
+
+/**
+ * Finalize the hashing operation and write the calculated hash into the given buffer
+ *
+ * This performs no heap allocation for hashes up to 4096 bits wide.
+ *
+ * @param w    Hash length
+ * @param out  Buffer to write the (w + 3) / 4 hexadecimal digits to (no terminator is added)
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+void Xsg<M, S0, S1, S2, S3>::hashFinal(std::size_t w, char *out) noexcept {
+  XSG_STAT_TIMER(statistics.outputTime);
   // blend it
   blend(1);
 
-  // accumulator vector
-  std::vector<bool> tmp;
+  // accumulator buffer
+  BitBuffer tmp(w);
   // extract as many bits as the hash will have (pseudohash)
-  for (std::size_t i = 0; i < w; i++) { tmp.push_back(next()); }
+  for (std::size_t i = 0; i < w; i++) { tmp.set(i, next()); }
   // feed each bit of the Elias-Omega coding of the hash's length and blend it
-  for (bool b : eliasOmegaCode(w)) { step(b); } blend(1);
-  // seal with the pseudohash, blend it, and clear the accumulator
-  for (bool b : tmp) { step(b); } blend(1); tmp.clear();
-  // extract as many bits as needed
-  for (std::size_t i = 0; i < w; i++) { tmp.push_back(next()); }
+  EliasOmega eo = eliasOmegaCode(w);
+  for (std::size_t i = 0; i < eo.size; i++) { step(eo[i]); } blend(1);
+  // seal with the pseudohash and blend it
+  for (std::size_t i = 0; i < w; i++) { step(tmp.get(i)); } blend(1);
+  // extract as many bits as needed, overwriting the accumulator
+  for (std::size_t i = 0; i < w; i++) { tmp.set(i, next()); }
+
+  // write the hex representation
+  bitBuffer2hex(tmp, w, out);
+}
+
+/**
+ * Finalize the hashing operation in extendable-output mode
+ *
+ * Finalizing in extendable-output mode entails:
+ *  - blending,
+ *  - blending (in lieu of the Elias-Omega coding for the width, ie. the
+ *    empty code of 0, which never collides with that of a positive width),
+ *  - sealing with a fixed-width pseudohash and blending,
+ * after which output may be squeezed indefinitely through the returned
+ * reader, using constant memory and without committing to any length.
+ *
+ * @return a reader squeezing the hash's output
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+typename Xsg<M, S0, S1, S2, S3>::XofReader Xsg<M, S0, S1, S2, S3>::finalizeXof() noexcept {
+  // blend it
+  blend(1);
+
+  // extract the fixed-width pseudohash
+  BitBuffer tmp(xofSealWidth);
+  for (std::size_t i = 0; i < xofSealWidth; i++) { tmp.set(i, next()); }
+  // the Elias-Omega code of 0 is empty, so just blend
+  blend(1);
+  // seal with the pseudohash and blend it
+  for (std::size_t i = 0; i < xofSealWidth; i++) { step(tmp.get(i)); } blend(1);
+
+  return XofReader(*this);
+}
+
+/**
+ * Construct a reader squeezing from the given XSG
+ *
+ * @param x  XSG to squeeze from
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+Xsg<M, S0, S1, S2, S3>::XofReader::XofReader(Xsg &x) noexcept : xsg(&x), count(0) {}
+
+/**
+ * Squeeze the given number of output bytes into the given buffer
+ *
+ * Each byte is built from 8 consecutive output bits, MSB-first;
+ * squeezing n bytes and then m bytes yields exactly the same output as
+ * squeezing n + m bytes at once.
+ *
+ * @param out  Buffer to write the bytes to
+ * @param n    Number of bytes to squeeze
+ * @return the current reader
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+typename Xsg<M, S0, S1, S2, S3>::XofReader &Xsg<M, S0, S1, S2, S3>::XofReader::read(std::uint8_t *out, std::size_t n) noexcept {
+  XSG_STAT_TIMER(xsg->statistics.outputTime);
+  for (std::size_t i = 0; i < n; i++) {
+    std::uint8_t c = 0;
+    for (std::size_t j = 0; j < 8; j++) { c = static_cast<std::uint8_t>((c << 1) | xsg->next(false)); }
+    out[i] = c;
+  }
+  count += n;
+  return *this;
+}
+
+/**
+ * Retrieve the number of bytes squeezed so far
+ *
+ * @return the number of bytes squeezed so far
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+std::uint64_t Xsg<M, S0, S1, S2, S3>::XofReader::squeezed() const noexcept {
+  return count;
+}
+
+/**
+ * Record the current state as the keyed state to return to upon reset()
+ *
+ * Only the LFSR registers and ICG states are recorded, generators,
+ * parameters, and tables are never modified by stepping.
+ *
+ * @return the current XSG
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::saveKeyedState() noexcept {
+  keyed = capture();
+  return *this;
+}
+
+/**
+ * Return to the last recorded keyed state, discarding any ongoing hashing operation
+ *
+ * If no state was ever recorded, the state upon construction is used.
+ *
+ * @return the current XSG
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::reset() noexcept {
+  master.seed(keyed.master);
+  slave0.seed(keyed.slave0); slave1.seed(keyed.slave1); slave2.seed(keyed.slave2); slave3.seed(keyed.slave3);
+  std::array<Icg *, 36> all = icgs();
+  for (std::size_t i = 0; i < all.size(); i++) { all[i]->seed(keyed.icg[i]); }
+  return *this;
+}
+
+/**
+ * Retrieve the hot-path statistics collected so far
+ *
+ * Statistics are only collected when compiling with XSG_STATS defined.
+ *
+ * @return the statistics collected (all-zero if disabled)
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+XsgStats Xsg<M, S0, S1, S2, S3>::stats() const noexcept {
+#ifdef XSG_STATS
+  return statistics;
+#else
+  return XsgStats();
+#endif
+}
+
+/**
+ * Clear the hot-path statistics collected so far
+ *
+ * @return the current XSG
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::clearStats() noexcept {
+  XSG_STAT(statistics = XsgStats());
+  return *this;
+}
+
+/**
+ * Account the given time as spent distilling this XSG
+ *
+ * @param t  Time spent
+ * @return the current XSG
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+Xsg<M, S0, S1, S2, S3> &Xsg<M, S0, S1, S2, S3>::addDistillTime(std::chrono::nanoseconds t) noexcept {
+  XSG_STAT(statistics.distillTime += t);
+  static_cast<void>(t);
+  return *this;
+}
+
+/**
+ * Retrieve pointers to all the ICGs, in declaration order
+ *
+ * @return an array of pointers to every ICG
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+std::array<Icg *, 36> Xsg<M, S0, S1, S2, S3>::icgs() noexcept {
+  return {{
+    &slave0low1, &slave0mid1, &slave0high1, &slave0low2, &slave0mid2, &slave0high2, &slave0low3, &slave0mid3, &slave0high3,
+    &slave1low0, &slave1mid0, &slave1high0, &slave1low2, &slave1mid2, &slave1high2, &slave1low3, &slave1mid3, &slave1high3,
+    &slave2low0, &slave2mid0, &slave2high0, &slave2low1, &slave2mid1, &slave2high1, &slave2low3, &slave2mid3, &slave2high3,
+    &slave3low0, &slave3mid0, &slave3high0, &slave3low1, &slave3mid1, &slave3high1, &slave3low2, &slave3mid2, &slave3high2,
+  }};
+}
+
+/**
+ * Capture every mutable register
+ *
+ * @return the captured registers
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+typename Xsg<M, S0, S1, S2, S3>::Registers Xsg<M, S0, S1, S2, S3>::capture() noexcept {
+  Registers ret = {master.getState(), slave0.getState(), slave1.getState(), slave2.getState(), slave3.getState(), {{}}};
+  std::array<Icg *, 36> all = icgs();
+  for (std::size_t i = 0; i < all.size(); i++) { ret.icg[i] = all[i]->get(); }
+  return ret;
+}
+
+/**
+ * Feed the given bytes, MSB-first, into the XSG
+ *
+ * This is equivalent to calling step() for every bit of the given bytes,
+ * but processes 64 bits at a time: since the master evolves independently
+ * of the data and the slaves, the slave selectors for a whole word are
+ * computed upfront, and data bits are shifted out of a single word.
+ *
+ * @param data  Bytes to feed
+ * @param n     Number of bytes to feed
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+void Xsg<M, S0, S1, S2, S3>::absorb(char const *data, std::size_t n) noexcept {
+  std::array<std::uint8_t, 64> sel;
+  while (0 < n) {
+    // load up to 8 bytes big-endian, so that the first bit to feed is the MSB
+    std::size_t len = n < 8 ? n : 8;
+    std::uint64_t word = 0;
+    for (std::size_t i = 0; i < len; i++) { word = (word << 8) | static_cast<std::uint8_t>(data[i]); }
+    word <<= 8 * (8 - len);
+    // precompute selectors and feed
+    selectors(sel.data(), 8 * len);
+    for (std::size_t i = 0; i < 8 * len; i++, word <<= 1) { stepSlave(sel[i], word >> 63); }
+    data += len; n -= len;
+  }
+}
+
+/**
+ * Advance the master for the given number of steps and record each step's slave selector
+ *
+ * @param sel  Where to store the selectors
+ * @param n    Number of steps to precompute
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+void Xsg<M, S0, S1, S2, S3>::selectors(std::uint8_t *sel, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    // the first master output is the selector's low bit, the second one its high bit
+    std::uint8_t lo = master.next(), hi = master.next();
+    sel[i] = static_cast<std::uint8_t>(lo + 2 * hi);
+    if (includeMaster) { master.step(); }
+  }
+}
 
-  // return the hex representation
-  return boolVector2hex(tmp);
+/**
+ * Step the given slave as needed, XORing the given value in
+ *
+ * @param sel  Slave to step
+ * @param val  Value to XOR in
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3>
+void Xsg<M, S0, S1, S2, S3>::stepSlave(std::uint8_t sel, bool val) noexcept {
+  XSG_STAT(statistics.selections[sel & 3u]++);
+  switch (sel) {
+    case 0: step0(val); break;
+    case 1: step1(val); break;
+    case 2: step2(val); break;
+    case 3: step3(val); break;
+    default:            break;
+  }
 }
 
 /**
@@ -425,6 +810,7 @@ void Xsg<M, S0, S1, S2, S3>::step0(bool val) noexcept {
   std::size_t as = 4u * maj3(slave1.get(slave1high0.next()), slave2.get(slave2high0.next()), slave3.get(slave3high0.next()))
                  + 2u * maj3(slave1.get( slave1mid0.next()), slave2.get( slave2mid0.next()), slave3.get( slave3mid0.next()))
                  + 1u * maj3(slave1.get( slave1low0.next()), slave2.get( slave2low0.next()), slave3.get( slave3low0.next()));
+  XSG_STAT(statistics.extraSteps[0][as]++);
   for (std::size_t i = 0; i < as; i++) { slave0.step(); }
 }
 
@@ -443,6 +829,7 @@ void Xsg<M, S0, S1, S2, S3>::step1(bool val) noexcept {
   std::size_t as = 4u * maj3(slave0.get(slave0high1.next()), slave2.get(slave2high1.next()), slave3.get(slave3high1.next()))
                  + 2u * maj3(slave0.get( slave0mid1.next()), slave2.get( slave2mid1.next()), slave3.get( slave3mid1.next()))
                  + 1u * maj3(slave0.get( slave0low1.next()), slave2.get( slave2low1.next()), slave3.get( slave3low1.next()));
+  XSG_STAT(statistics.extraSteps[1][as]++);
   for (std::size_t i = 0; i < as; i++) { slave1.step(); }
 }
 
@@ -461,6 +848,7 @@ void Xsg<M, S0, S1, S2, S3>::step2(bool val) noexcept {
   std::size_t as = 4u * maj3(slave0.get(slave0high2.next()), slave1.get(slave1high2.next()), slave3.get(slave3high2.next()))
                  + 2u * maj3(slave0.get( slave0mid2.next()), slave1.get( slave1mid2.next()), slave3.get( slave3mid2.next()))
                  + 1u * maj3(slave0.get( slave0low2.next()), slave1.get( slave1low2.next()), slave3.get( slave3low2.next()));
+  XSG_STAT(statistics.extraSteps[2][as]++);
   for (std::size_t i = 0; i < as; i++) { slave2.step(); }
 }
 
@@ -479,6 +867,7 @@ void Xsg<M, S0, S1, S2, S3>::step3(bool val) noexcept {
   std::size_t as = 4u * maj3(slave0.get(slave0high3.next()), slave1.get(slave1high3.next()), slave2.get(slave2high3.next()))
                  + 2u * maj3(slave0.get( slave0mid3.next()), slave1.get( slave1mid3.next()), slave2.get( slave2mid3.next()))
                  + 1u * maj3(slave0.get( slave0low3.next()), slave1.get( slave1low3.next()), slave2.get( slave2low3.next()));
+  XSG_STAT(statistics.extraSteps[3][as]++);
   for (std::size_t i = 0; i < as; i++) { slave3.step(); }
 }
 
@@ -0,0 +1,275 @@
+#ifndef XSG_LANES_H__
+#define XSG_LANES_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Lfsr.h"
+#include "Xsg.h"
+
+
+/**
+ * Multi-lane LFSR class
+ *
+ * This class holds L LFSRs of the same size and generator, stepping them in
+ * lockstep (or under a per-lane mask); word w of lane l is stored at
+ * position w * L + l, so that every word operation is a loop over the
+ * lanes which the compiler can vectorize (AVX2 / AVX-512 with the default
+ * machine flags).
+ *
+ * Per-lane values are given as masks, each lane being either everywhere-0
+ * or everywhere-1.
+ *
+ * @param N  LFSR register size
+ * @param L  Number of lanes
+ */
+template <std::size_t N, std::size_t L>
+class LaneLfsr {
+  public:
+    /**
+     * Per-lane mask type
+     *
+     */
+    using Mask = std::array<std::uint64_t, L>;
+
+    /**
+     * Number of words per lane
+     *
+     */
+    static constexpr std::size_t W = (N + 63) / 64;
+
+    /**
+     * Construct a multi-lane LFSR with every lane equal to the given LFSR
+     *
+     * @param proto  LFSR to take the generator and initial state from
+     */
+    explicit LaneLfsr(Lfsr<N> const &proto) noexcept;
+
+    /**
+     * Re-seed every lane with the given LFSR's state
+     *
+     * @param proto  LFSR to take the state from
+     * @return the current multi-lane LFSR
+     */
+    LaneLfsr &load(Lfsr<N> const &proto) noexcept;
+
+    /**
+     * Step every lane once, XORing the given per-lane values in
+     *
+     * @param val  Per-lane values to XOR in
+     * @return the current multi-lane LFSR
+     */
+    LaneLfsr &step(Mask const &val) noexcept;
+
+    /**
+     * Step the lanes selected by the given mask once, leaving the rest untouched
+     *
+     * @param mask  Lanes to step
+     * @return the current multi-lane LFSR
+     */
+    LaneLfsr &stepMasked(Mask const &mask) noexcept;
+
+    /**
+     * Get the given bit of every lane
+     *
+     * @param i  Index to return
+     * @return the per-lane values of the given bit
+     */
+    Mask get(std::size_t i = 0) const noexcept;
+
+  protected:
+    /**
+     * Step the lanes selected by the given mask once, XORing the given per-lane values in
+     *
+     * This mirrors Lfsr::step() lane by lane.
+     *
+     * @param val   Per-lane values to XOR in
+     * @param mask  Lanes to step
+     */
+    void advance(Mask const &val, Mask const &mask) noexcept;
+
+    /**
+     * Interleaved lane registers
+     *
+     */
+    std::array<std::uint64_t, W * L> state;
+
+    /**
+     * Shared generator, as words
+     *
+     */
+    std::array<std::uint64_t, W> generator;
+};
+
+
+/**
+ * Multi-lane XSG hashing engine
+ *
+ * When hashing under a single key, every message starts from the same state
+ * and, for messages of equal length, the master and the ICGs evolve exactly
+ * in the same way for all of them, only the slaves' contents (and hence the
+ * number of additional slave steps) depend on the data.
+ *
+ * This engine hashes L equal-length messages at once: the master and ICGs
+ * are stepped once for all the lanes, while the slaves are held as
+ * multi-lane LFSRs, additional steps being applied under per-lane masks.
+ * The resulting digests are exactly those of the scalar Xsg::hash().
+ *
+ * @param M   Master LFSR size
+ * @param S0  Slave 0 LFSR size
+ * @param S1  Slave 1 LFSR size
+ * @param S2  Slave 2 LFSR size
+ * @param S3  Slave 3 LFSR size
+ * @param L   Number of lanes (at most 64)
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+class XsgLanes {
+  // Pseudohash bits for every lane are packed into a single word
+  static_assert(0 < L && L <= 64, "The number of lanes should be between 1 and 64");
+
+  public:
+    /**
+     * Per-lane mask type
+     *
+     */
+    using Mask = std::array<std::uint64_t, L>;
+
+    /**
+     * Construct a multi-lane engine hashing from the given XSG's current state
+     *
+     * @param prototype  Keyed XSG to start every message from
+     */
+    explicit XsgLanes(Xsg<M, S0, S1, S2, S3> const &prototype) noexcept;
+
+    /**
+     * Hash L messages of equal length at once
+     *
+     * @param msgs  L messages to hash, all of them of the same length
+     * @param w     Width of the hashes to be generated
+     * @param out   Buffer to write L * ((w + 3) / 4) hexadecimal digits to, back to back
+     */
+    void hash(std::string const *msgs, std::size_t w, char *out) noexcept;
+
+    /**
+     * Hash an arbitrary number of messages of arbitrary lengths
+     *
+     * Messages are bucketed by length and hashed L at a time, buckets filling
+     * less than a quarter of the lanes are hashed one by one instead.
+     *
+     * @param msgs  Messages to hash
+     * @param w     Width of the hashes to be generated
+     * @param out   Buffer to write msgs.size() * ((w + 3) / 4) hexadecimal digits to, back to back
+     */
+    void hashMany(std::vector<std::string> const &msgs, std::size_t w, char *out) noexcept;
+
+  protected:
+    /**
+     * Hash L messages of equal length at once, writing each digest to its own buffer
+     *
+     * @param msgs  Per-lane messages to hash
+     * @param w     Width of the hashes to be generated
+     * @param outs  Per-lane buffers to write the (w + 3) / 4 hexadecimal digits to
+     */
+    void hashLanes(std::array<std::string const *, L> const &msgs, std::size_t w, std::array<char *, L> const &outs) noexcept;
+
+    /**
+     * Return every lane to the prototype's state
+     *
+     */
+    void reset() noexcept;
+
+    /**
+     * Get the per-lane XSG output
+     *
+     * @return the per-lane output
+     */
+    Mask get() const noexcept;
+
+    /**
+     * Step every lane, XORing in the given per-lane values
+     *
+     * @param val  Per-lane values to XOR in
+     */
+    void step(Mask const &val) noexcept;
+
+    /**
+     * Step the given slave in every lane as needed, XORing the given per-lane values in
+     *
+     * @param sel  Slave to step
+     * @param val  Per-lane values to XOR in
+     */
+    void stepSlave(std::uint8_t sel, Mask const &val) noexcept;
+
+    /**
+     * Blend every lane's slaves (and the master, if included in the output)
+     *
+     * @param additionalRounds  Additional rounds to apply
+     */
+    void blend(std::size_t additionalRounds) noexcept;
+
+    /**
+     * Apply the additional steps to the given multi-lane slave
+     *
+     * @param slave  Slave to step
+     * @param high   Per-lane high bit of the additional step count
+     * @param mid    Per-lane mid bit of the additional step count
+     * @param low    Per-lane low bit of the additional step count
+     */
+    template <std::size_t N>
+    static void stepAs(LaneLfsr<N, L> &slave, Mask const &high, Mask const &mid, Mask const &low) noexcept;
+
+    /**
+     * Per-lane majority function of 3 inputs
+     *
+     * @param x  Input 1
+     * @param y  Input 2
+     * @param z  Input 3
+     * @return the per-lane majority
+     */
+    static Mask maj3(Mask const &x, Mask const &y, Mask const &z) noexcept;
+
+    /**
+     * Scalar XSG providing the (shared) master and ICGs
+     *
+     */
+    Xsg<M, S0, S1, S2, S3> control;
+
+    /**
+     * Multi-lane Slave 0
+     *
+     */
+    LaneLfsr<S0, L> slave0;
+
+    /**
+     * Multi-lane Slave 1
+     *
+     */
+    LaneLfsr<S1, L> slave1;
+
+    /**
+     * Multi-lane Slave 2
+     *
+     */
+    LaneLfsr<S2, L> slave2;
+
+    /**
+     * Multi-lane Slave 3
+     *
+     */
+    LaneLfsr<S3, L> slave3;
+};
+
+/**
+ * Xsg512Lanes is the multi-lane engine for the canonical XSG
+ *
+ */
+template <std::size_t L>
+using Xsg512Lanes = XsgLanes<521, 523, 541, 547, 557, L>;
+
+
+#include "XsgLanes.hpp"
+
+#endif  /* XSG_LANES_H__ */
@@ -0,0 +1,396 @@
+#ifndef XSG_LANES_HPP__
+#define XSG_LANES_HPP__
+
+#include "XsgLanes.h"
+
+#include <algorithm>
+#include <numeric>
+
+
+/**
+ * Construct a multi-lane LFSR with every lane equal to the given LFSR
+ *
+ * @param proto  LFSR to take the generator and initial state from
+ */
+template <std::size_t N, std::size_t L>
+LaneLfsr<N, L>::LaneLfsr(Lfsr<N> const &proto) noexcept : state(), generator() {
+  for (std::size_t i = 0; i < N; i++) {
+    if (proto.getGenerator()[i]) { generator[i / 64] |= std::uint64_t(1) << (i % 64); }
+  }
+  load(proto);
+}
+
+/**
+ * Re-seed every lane with the given LFSR's state
+ *
+ * @param proto  LFSR to take the state from
+ * @return the current multi-lane LFSR
+ */
+template <std::size_t N, std::size_t L>
+LaneLfsr<N, L> &LaneLfsr<N, L>::load(Lfsr<N> const &proto) noexcept {
+  std::array<std::uint64_t, W> words = {{}};
+  for (std::size_t i = 0; i < N; i++) {
+    if (proto.getState()[i]) { words[i / 64] |= std::uint64_t(1) << (i % 64); }
+  }
+  for (std::size_t w = 0; w < W; w++) {
+    for (std::size_t l = 0; l < L; l++) { state[w * L + l] = words[w]; }
+  }
+  return *this;
+}
+
+/**
+ * Step every lane once, XORing the given per-lane values in
+ *
+ * @param val  Per-lane values to XOR in
+ * @return the current multi-lane LFSR
+ */
+template <std::size_t N, std::size_t L>
+LaneLfsr<N, L> &LaneLfsr<N, L>::step(Mask const &val) noexcept {
+  Mask all; all.fill(~std::uint64_t(0));
+  advance(val, all);
+  return *this;
+}
+
+/**
+ * Step the lanes selected by the given mask once, leaving the rest untouched
+ *
+ * @param mask  Lanes to step
+ * @return the current multi-lane LFSR
+ */
+template <std::size_t N, std::size_t L>
+LaneLfsr<N, L> &LaneLfsr<N, L>::stepMasked(Mask const &mask) noexcept {
+  Mask none; none.fill(0);
+  advance(none, mask);
+  return *this;
+}
+
+/**
+ * Get the given bit of every lane
+ *
+ * @param i  Index to return
+ * @return the per-lane values of the given bit
+ */
+template <std::size_t N, std::size_t L>
+typename LaneLfsr<N, L>::Mask LaneLfsr<N, L>::get(std::size_t i) const noexcept {
+  Mask ret;
+  std::size_t w = i / 64, b = i % 64;
+  for (std::size_t l = 0; l < L; l++) { ret[l] = -((state[w * L + l] >> b) & 1u); }
+  return ret;
+}
+
+/**
+ * Step the lanes selected by the given mask once, XORing the given per-lane values in
+ *
+ * This mirrors Lfsr::step() lane by lane.
+ *
+ * @param val   Per-lane values to XOR in
+ * @param mask  Lanes to step
+ */
+template <std::size_t N, std::size_t L>
+void LaneLfsr<N, L>::advance(Mask const &val, Mask const &mask) noexcept {
+  constexpr std::uint64_t top = std::uint64_t(1) << ((N - 1) % 64);
+  constexpr std::uint64_t last = top | (top - 1);
+
+  // every lane's output bit, and running ORs to detect everywhere-0 results
+  Mask lsb, any;
+  for (std::size_t l = 0; l < L; l++) { lsb[l] = -(state[l] & 1u); any[l] = 0; }
+
+  // shift right by one, XOR the generator in where the output was set, and keep unselected lanes
+  for (std::size_t w = 0; w < W; w++) {
+    for (std::size_t l = 0; l < L; l++) {
+      std::uint64_t old = state[w * L + l];
+      std::uint64_t nxt = (old >> 1) ^ (generator[w] & lsb[l]);
+      nxt ^= w + 1 < W ? state[(w + 1) * L + l] << 63 : top & val[l];
+      nxt = (nxt & mask[l]) | (old & ~mask[l]);
+      state[w * L + l] = nxt;
+      any[l] |= nxt;
+    }
+  }
+
+  // flip everywhere-0 lanes to everywhere-1
+  std::uint64_t zeros = 0;
+  for (std::size_t l = 0; l < L; l++) { zeros |= (0 == any[l]); }
+  if (zeros) {
+    for (std::size_t w = 0; w < W; w++) {
+      for (std::size_t l = 0; l < L; l++) {
+        state[w * L + l] |= (w + 1 < W ? ~std::uint64_t(0) : last) & -static_cast<std::uint64_t>(0 == any[l]);
+      }
+    }
+  }
+}
+
+
+/**
+ * Construct a multi-lane engine hashing from the given XSG's current state
+ *
+ * @param prototype  Keyed XSG to start every message from
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+XsgLanes<M, S0, S1, S2, S3, L>::XsgLanes(Xsg<M, S0, S1, S2, S3> const &prototype) noexcept
+: control(prototype), slave0(prototype.slave0), slave1(prototype.slave1), slave2(prototype.slave2), slave3(prototype.slave3) {
+  control.saveKeyedState();
+}
+
+/**
+ * Hash L messages of equal length at once
+ *
+ * @param msgs  L messages to hash, all of them of the same length
+ * @param w     Width of the hashes to be generated
+ * @param out   Buffer to write L * ((w + 3) / 4) hexadecimal digits to, back to back
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+void XsgLanes<M, S0, S1, S2, S3, L>::hash(std::string const *msgs, std::size_t w, char *out) noexcept {
+  std::array<std::string const *, L> ms;
+  std::array<char *, L> outs;
+  for (std::size_t l = 0; l < L; l++) { ms[l] = &msgs[l]; outs[l] = out + l * ((w + 3) / 4); }
+  hashLanes(ms, w, outs);
+}
+
+/**
+ * Hash an arbitrary number of messages of arbitrary lengths
+ *
+ * Messages are bucketed by length and hashed L at a time, buckets filling
+ * less than a quarter of the lanes are hashed one by one instead.
+ *
+ * @param msgs  Messages to hash
+ * @param w     Width of the hashes to be generated
+ * @param out   Buffer to write msgs.size() * ((w + 3) / 4) hexadecimal digits to, back to back
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+void XsgLanes<M, S0, S1, S2, S3, L>::hashMany(std::vector<std::string> const &msgs, std::size_t w, char *out) noexcept {
+  std::size_t stride = (w + 3) / 4, n = msgs.size();
+
+  // bucket by length
+  std::vector<std::size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&msgs](std::size_t a, std::size_t b) { return msgs[a].size() < msgs[b].size(); });
+
+  // scratch output for padding lanes
+  std::string scratch(stride, '0');
+
+  for (std::size_t i = 0, j; i < n; i = j) {
+    for (j = i; j < n && j - i < L && msgs[order[j]].size() == msgs[order[i]].size(); j++) {}
+
+    if (4 * (j - i) < L) {
+      // too few to be worth it, hash one by one
+      for (std::size_t k = i; k < j; k++) {
+        control.reset();
+        control.hash(msgs[order[k]], w, out + order[k] * stride);
+      }
+    } else {
+      // fill every lane, padding with the first message in the bucket
+      std::array<std::string const *, L> ms;
+      std::array<char *, L> outs;
+      for (std::size_t l = 0; l < L; l++) {
+        bool real = i + l < j;
+        ms[l] = &msgs[order[real ? i + l : i]];
+        outs[l] = real ? out + order[i + l] * stride : &scratch[0];
+      }
+      hashLanes(ms, w, outs);
+    }
+  }
+}
+
+/**
+ * Hash L messages of equal length at once, writing each digest to its own buffer
+ *
+ * This mirrors Xsg::hashAdd() followed by Xsg::hashFinal() lane by lane.
+ *
+ * @param msgs  Per-lane messages to hash
+ * @param w     Width of the hashes to be generated
+ * @param outs  Per-lane buffers to write the (w + 3) / 4 hexadecimal digits to
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+void XsgLanes<M, S0, S1, S2, S3, L>::hashLanes(std::array<std::string const *, L> const &msgs, std::size_t w, std::array<char *, L> const &outs) noexcept {
+  Mask none, all, val;
+  none.fill(0); all.fill(~std::uint64_t(0));
+
+  reset();
+
+  // feed each bit of every message, MSB-first, precomputing the shared selectors a byte at a time
+  std::array<std::uint8_t, 8> sel;
+  for (std::size_t i = 0; i < msgs[0]->size(); i++) {
+    control.selectors(sel.data(), 8);
+    for (std::size_t b = 0; b < 8; b++) {
+      for (std::size_t l = 0; l < L; l++) { val[l] = -static_cast<std::uint64_t>((static_cast<std::uint8_t>((*msgs[l])[i]) >> (7 - b)) & 1u); }
+      stepSlave(sel[b], val);
+    }
+  }
+
+  // blend it
+  blend(1);
+
+  // per-position lane bits, used for the pseudohash and then the hash proper
+  std::vector<std::uint64_t> tmp(w);
+  // extract as many bits as the hash will have (pseudohash)
+  for (std::size_t i = 0; i < w; i++) {
+    step(none);
+    Mask o = get();
+    for (std::size_t l = 0; l < L; l++) { tmp[i] |= (o[l] & 1u) << l; }
+  }
+  // feed each bit of the Elias-Omega coding of the hash's length and blend it
+  EliasOmega eo = eliasOmegaCode(w);
+  for (std::size_t i = 0; i < eo.size; i++) { step(eo[i] ? all : none); } blend(1);
+  // seal with the pseudohash and blend it
+  for (std::size_t i = 0; i < w; i++) {
+    for (std::size_t l = 0; l < L; l++) { val[l] = -((tmp[i] >> l) & 1u); }
+    step(val);
+  }
+  blend(1);
+  // extract as many bits as needed, overwriting the accumulator
+  for (std::size_t i = 0; i < w; i++) {
+    step(none);
+    Mask o = get();
+    tmp[i] = 0;
+    for (std::size_t l = 0; l < L; l++) { tmp[i] |= (o[l] & 1u) << l; }
+  }
+
+  // write the hex representation of every lane (see bitBuffer2hex)
+  std::size_t len = (w + 3) / 4;
+  for (std::size_t l = 0; l < L; l++) {
+    for (std::size_t k = 0; k < len; k++) {
+      std::size_t hi = w - 4 * k, lo = hi < 4 ? 0 : hi - 4, d = 0;
+      for (std::size_t i = hi; i > lo; i--) { d = (d << 1) | ((tmp[i - 1] >> l) & 1u); }
+      outs[l][len - 1 - k] = hex[d];
+    }
+  }
+}
+
+/**
+ * Return every lane to the prototype's state
+ *
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+void XsgLanes<M, S0, S1, S2, S3, L>::reset() noexcept {
+  control.reset();
+  slave0.load(control.slave0);
+  slave1.load(control.slave1);
+  slave2.load(control.slave2);
+  slave3.load(control.slave3);
+}
+
+/**
+ * Get the per-lane XSG output
+ *
+ * @return the per-lane output
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+typename XsgLanes<M, S0, S1, S2, S3, L>::Mask XsgLanes<M, S0, S1, S2, S3, L>::get() const noexcept {
+  Mask s0 = slave0.get(), s1 = slave1.get(), s2 = slave2.get(), s3 = slave3.get(), ret;
+  std::uint64_t m = -static_cast<std::uint64_t>(control.includeMaster && control.master.get());
+  for (std::size_t l = 0; l < L; l++) { ret[l] = s0[l] ^ s1[l] ^ s2[l] ^ s3[l] ^ m; }
+  return ret;
+}
+
+/**
+ * Step every lane, XORing in the given per-lane values
+ *
+ * @param val  Per-lane values to XOR in
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+void XsgLanes<M, S0, S1, S2, S3, L>::step(Mask const &val) noexcept {
+  std::uint8_t sel;
+  control.selectors(&sel, 1);
+  stepSlave(sel, val);
+}
+
+/**
+ * Step the given slave in every lane as needed, XORing the given per-lane values in
+ *
+ * The ICGs are shared by every lane, so only the slave bits they point to
+ * (and hence the additional step counts) differ from lane to lane.
+ *
+ * @param sel  Slave to step
+ * @param val  Per-lane values to XOR in
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+void XsgLanes<M, S0, S1, S2, S3, L>::stepSlave(std::uint8_t sel, Mask const &val) noexcept {
+  Xsg<M, S0, S1, S2, S3> &c = control;
+  switch (sel) {
+    case 0:
+      slave0.step(val);
+      stepAs(slave0, maj3(slave1.get(c.slave1high0.next()), slave2.get(c.slave2high0.next()), slave3.get(c.slave3high0.next())),
+                     maj3(slave1.get( c.slave1mid0.next()), slave2.get( c.slave2mid0.next()), slave3.get( c.slave3mid0.next())),
+                     maj3(slave1.get( c.slave1low0.next()), slave2.get( c.slave2low0.next()), slave3.get( c.slave3low0.next())));
+      break;
+    case 1:
+      slave1.step(val);
+      stepAs(slave1, maj3(slave0.get(c.slave0high1.next()), slave2.get(c.slave2high1.next()), slave3.get(c.slave3high1.next())),
+                     maj3(slave0.get( c.slave0mid1.next()), slave2.get( c.slave2mid1.next()), slave3.get( c.slave3mid1.next())),
+                     maj3(slave0.get( c.slave0low1.next()), slave2.get( c.slave2low1.next()), slave3.get( c.slave3low1.next())));
+      break;
+    case 2:
+      slave2.step(val);
+      stepAs(slave2, maj3(slave0.get(c.slave0high2.next()), slave1.get(c.slave1high2.next()), slave3.get(c.slave3high2.next())),
+                     maj3(slave0.get( c.slave0mid2.next()), slave1.get( c.slave1mid2.next()), slave3.get( c.slave3mid2.next())),
+                     maj3(slave0.get( c.slave0low2.next()), slave1.get( c.slave1low2.next()), slave3.get( c.slave3low2.next())));
+      break;
+    case 3:
+      slave3.step(val);
+      stepAs(slave3, maj3(slave0.get(c.slave0high3.next()), slave1.get(c.slave1high3.next()), slave2.get(c.slave2high3.next())),
+                     maj3(slave0.get( c.slave0mid3.next()), slave1.get( c.slave1mid3.next()), slave2.get( c.slave2mid3.next())),
+                     maj3(slave0.get( c.slave0low3.next()), slave1.get( c.slave1low3.next()), slave2.get( c.slave2low3.next())));
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Blend every lane's slaves (and the master, if included in the output)
+ *
+ * @param additionalRounds  Additional rounds to apply
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+void XsgLanes<M, S0, S1, S2, S3, L>::blend(std::size_t additionalRounds) noexcept {
+  Mask none; none.fill(0);
+  if (control.includeMaster) { for (std::size_t i = 0; i < (additionalRounds + 1) * M; i++) { control.master.step(); } }
+  for (std::size_t i = 0; i < (additionalRounds + 1) * S0; i++) { slave0.step(none); }
+  for (std::size_t i = 0; i < (additionalRounds + 1) * S1; i++) { slave1.step(none); }
+  for (std::size_t i = 0; i < (additionalRounds + 1) * S2; i++) { slave2.step(none); }
+  for (std::size_t i = 0; i < (additionalRounds + 1) * S3; i++) { slave3.step(none); }
+}
+
+/**
+ * Apply the additional steps to the given multi-lane slave
+ *
+ * Lanes are stepped under a mask as long as any of them still needs it.
+ *
+ * @param slave  Slave to step
+ * @param high   Per-lane high bit of the additional step count
+ * @param mid    Per-lane mid bit of the additional step count
+ * @param low    Per-lane low bit of the additional step count
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+template <std::size_t N>
+void XsgLanes<M, S0, S1, S2, S3, L>::stepAs(LaneLfsr<N, L> &slave, Mask const &high, Mask const &mid, Mask const &low) noexcept {
+  std::array<std::uint8_t, L> as;
+  std::uint8_t most = 0;
+  for (std::size_t l = 0; l < L; l++) {
+    as[l] = static_cast<std::uint8_t>((high[l] & 4u) | (mid[l] & 2u) | (low[l] & 1u));
+    most = std::max(most, as[l]);
+  }
+  Mask mask;
+  for (std::uint8_t k = 0; k < most; k++) {
+    for (std::size_t l = 0; l < L; l++) { mask[l] = -static_cast<std::uint64_t>(k < as[l]); }
+    slave.stepMasked(mask);
+  }
+}
+
+/**
+ * Per-lane majority function of 3 inputs
+ *
+ * @param x  Input 1
+ * @param y  Input 2
+ * @param z  Input 3
+ * @return the per-lane majority
+ */
+template <std::size_t M, std::size_t S0, std::size_t S1, std::size_t S2, std::size_t S3, std::size_t L>
+typename XsgLanes<M, S0, S1, S2, S3, L>::Mask XsgLanes<M, S0, S1, S2, S3, L>::maj3(Mask const &x, Mask const &y, Mask const &z) noexcept {
+  Mask ret;
+  for (std::size_t l = 0; l < L; l++) { ret[l] = (x[l] & y[l]) | (x[l] & z[l]) | (y[l] & z[l]); }
+  return ret;
+}
+
+
+#endif  /* XSG_LANES_HPP__ */
@@ -0,0 +1,25 @@
+#include "XsgStats.h"
+
+#include <ostream>
+
+
+/**
+ * Dump the given statistics in human-readable form
+ *
+ * @param os  Stream to dump to
+ * @param s   Statistics to dump
+ * @return the given stream
+ */
+std::ostream &operator<<(std::ostream &os, XsgStats const &s) {
+  os << "slave selections:" << std::endl;
+  for (std::size_t k = 0; k < 4; k++) {
+    os << "  slave " << k << ": " << s.selections[k] << " (extra steps:";
+    for (std::size_t as = 0; as < 8; as++) { os << ' ' << as << '=' << s.extraSteps[k][as]; }
+    os << ')' << std::endl;
+  }
+  os << "blends: " << s.blends << " (" << s.blendSteps << " LFSR steps)" << std::endl
+     << "output bits: " << s.outputBits << std::endl
+     << "distill time: " << s.distillTime.count() << " ns" << std::endl
+     << "output time: " << s.outputTime.count() << " ns" << std::endl;
+  return os;
+}
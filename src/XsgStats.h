@@ -0,0 +1,143 @@
+#ifndef XSG_STATS_H__
+#define XSG_STATS_H__
+
+#include <cstdint>
+#include <array>
+#include <chrono>
+#include <iosfwd>
+
+
+/**
+ * Evaluate the given statement only when statistics are enabled
+ *
+ * Statistics are enabled by defining XSG_STATS at compile time; otherwise
+ * every use of this macro (and of XSG_STAT_TIMER) compiles to nothing.
+ *
+ */
+#ifdef XSG_STATS
+#define XSG_STAT(stmt) do { stmt; } while (false)
+#else
+#define XSG_STAT(stmt) do { } while (false)
+#endif
+
+/**
+ * Accumulate the time until the end of the enclosing scope into the given duration, only when statistics are enabled
+ *
+ */
+#ifdef XSG_STATS
+#define XSG_STAT_TIMER(acc) XsgStatsTimer xsgStatsTimer(acc)
+#else
+#define XSG_STAT_TIMER(acc) do { } while (false)
+#endif
+
+
+/**
+ * XSG hot-path statistics
+ *
+ * These are only collected when compiling with XSG_STATS defined, and are
+ * all-zero otherwise.
+ *
+ */
+struct XsgStats {
+  /**
+   * Number of times each slave was selected for stepping
+   *
+   */
+  std::array<std::uint64_t, 4> selections;
+
+  /**
+   * Histogram of additional steps (0 to 7) taken, per slave
+   *
+   */
+  std::array<std::array<std::uint64_t, 8>, 4> extraSteps;
+
+  /**
+   * Number of blend() calls
+   *
+   */
+  std::uint64_t blends;
+
+  /**
+   * Number of LFSR steps taken by blend()
+   *
+   */
+  std::uint64_t blendSteps;
+
+  /**
+   * Number of output bits extracted
+   *
+   */
+  std::uint64_t outputBits;
+
+  /**
+   * Time spent distilling the XSG from its key
+   *
+   */
+  std::chrono::nanoseconds distillTime;
+
+  /**
+   * Time spent hashing and squeezing extendable output
+   *
+   */
+  std::chrono::nanoseconds outputTime;
+};
+
+/**
+ * Dump the given statistics in human-readable form
+ *
+ * @param os  Stream to dump to
+ * @param s   Statistics to dump
+ * @return the given stream
+ */
+std::ostream &operator<<(std::ostream &os, XsgStats const &s);
+
+
+/**
+ * Scoped timer accumulating its lifetime into a duration
+ *
+ */
+class XsgStatsTimer {
+  public:
+    /**
+     * Start timing into the given duration
+     *
+     * @param a  Duration to accumulate into
+     */
+    explicit XsgStatsTimer(std::chrono::nanoseconds &a) noexcept : acc(a), start(std::chrono::steady_clock::now()) {}
+
+    /**
+     * Deleted copy constructor
+     *
+     */
+    XsgStatsTimer(XsgStatsTimer const &) = delete;
+
+    /**
+     * Deleted copy assignment
+     *
+     */
+    XsgStatsTimer &operator=(XsgStatsTimer const &) = delete;
+
+    /**
+     * Stop timing, accumulating the elapsed time
+     *
+     */
+    ~XsgStatsTimer() noexcept {
+      acc += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+  protected:
+    /**
+     * Duration to accumulate into
+     *
+     */
+    std::chrono::nanoseconds &acc;
+
+    /**
+     * Starting time
+     *
+     */
+    std::chrono::steady_clock::time_point start;
+};
+
+
+#endif  /* XSG_STATS_H__ */
@@ -1,14 +1,128 @@
+#include <cerrno>
+#include <cstdlib>
+#include <atomic>
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <csignal>
+#include <unistd.h>
 
 #include "Cloner.h"
 #include "BitGenerator.h"
 #include "Hasher.h"
 #include "Icg.h"
+#include "Keystream.h"
 #include "Lfsr.h"
+#include "StreamMonitor.h"
 #include "Xsg.h"
 
 
+namespace {
+  /**
+   * Flag raised upon SIGINT / SIGTERM, stopping keystream output
+   *
+   */
+  std::atomic<bool> interrupted(false);
+
+  /**
+   * Signal handler raising the interruption flag
+   *
+   */
+  extern "C" void interrupt(int) {
+    interrupted.store(true);
+  }
+
+  /**
+   * Parse the given string as a byte count
+   *
+   * Only plain decimal digits are accepted (no sign, whitespace, nor suffix).
+   *
+   * @param s    String to parse
+   * @param out  Where to store the parsed count
+   * @return true if s is a valid count in range, false otherwise
+   */
+  bool parseCount(std::string const &s, std::uint64_t &out) noexcept {
+    if (s.empty() || std::string::npos != s.find_first_not_of("0123456789")) { return false; }
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long v = std::strtoull(s.c_str(), &end, 10);
+    if (ERANGE == errno || '\0' != *end) { return false; }
+    out = v;
+    return true;
+  }
+
+  /**
+   * Run the `stream' subcommand, writing keystream to stdout
+   *
+   * @param prog  Program name
+   * @param args  Subcommand arguments
+   * @return the exit code
+   */
+  int stream(char const *prog, std::vector<std::string> const &args) {
+    std::string key;
+    bool keyed = false;
+    std::uint64_t bytes = 0;
+    bool monitored = false;
+    bool valid = true;
+    for (std::size_t i = 0; valid && i < args.size(); i++) {
+      bool more = i + 1 < args.size();
+      if      ("--key"   == args[i] && more) { key = args[++i]; keyed = true; }
+      else if ("--bytes" == args[i] && more) { valid = parseCount(args[++i], bytes); }
+      else if ("--monitor" == args[i])        { monitored = true; }
+      else { valid = false; }
+    }
+    if (!keyed || !valid) {
+      std::cerr << "Usage: " << prog << " stream --key K [--bytes N] [--monitor]" << std::endl
+                << "  --key K      key to distill the keystream generator from" << std::endl
+                << "  --bytes N    number of bytes to output (default: unlimited)" << std::endl
+                << "  --monitor    run statistical tests on the output, alerting on stderr" << std::endl;
+      return 2;
+    }
+
+    // stop cleanly (and report) on interruption or once the reader goes away
+    struct sigaction sa = {};
+    sa.sa_handler = interrupt;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Xsg512 gen = distillXsg(key);
+    Xsg512::XofReader reader(gen);
+    StreamMonitor monitor(6.0, [prog](std::vector<StreamMonitor::Statistic> const &bad) {
+      for (StreamMonitor::Statistic const &s : bad) { std::cerr << prog << ": ALERT " << s.name << " z = " << s.z << std::endl; }
+    });
+    StreamReport r;
+    try {
+      r = streamKeystream(STDOUT_FILENO, [&reader, &monitor, monitored](std::uint8_t *out, std::size_t n) {
+        reader.read(out, n);
+        if (monitored) { monitor.feed(out, n); }
+      }, bytes, interrupted);
+    } catch (std::system_error *e) {
+      std::cerr << prog << ": " << e->what() << std::endl;
+      delete e;
+      return 1;
+    }
+
+    double secs = static_cast<double>(r.elapsed.count()) / 1e9;
+    std::cerr << prog << ": " << r.bytes << " bytes in " << std::fixed << std::setprecision(3) << secs << " s ("
+              << (0.0 < secs ? static_cast<double>(r.bytes) / secs / 1048576.0 : 0.0) << " MiB/s, "
+              << (r.spliced ? "vmsplice" : "write") << (r.brokenPipe ? ", reader closed" : "") << ")" << std::endl;
+    if (monitored) {
+      std::cerr << prog << ": " << monitor.bits() << " bits monitored" << std::endl;
+      for (StreamMonitor::Statistic const &s : monitor.statistics()) { std::cerr << "  " << std::left << std::setw(20) << s.name << " z = " << s.z << std::endl; }
+    }
+    return 0;
+  }
+}
+
+
 int main(int argc, char *argv[]) {
+  if (1 < argc && std::string("stream") == argv[1]) { return stream(argv[0], std::vector<std::string>(argv + 2, argv + argc)); }
+
   // dump arguments to cerr
   std::cerr << "Arguments:" << std::endl; for (int i = 0; i < argc; i++) { std::cerr << "  " << i << ": " << argv[i] << std::endl; } std::cerr << std::endl;
 
@@ -31,18 +145,17 @@ int main(int argc, char *argv[]) {
   gen3.hashAdd(s0); std::cout << s0 << ": " << gen3.hashPartial(128) << std::endl;
   gen3.hashAdd(s3); std::cout << s3 << ": " << gen3.hashFinal(128)   << std::endl;
 
-  return 0;
-
-  // generate infinite stream
-  while (true) {
-    unsigned char c = 0;
-    for (std::size_t j = 0; j < 8; j++) {
-      c = static_cast<unsigned char>(c << 1);
-      c = static_cast<unsigned char>(c | gen1.next());
-    }
-    std::cout << c;
+  // dump hot-path statistics to cerr, if requested
+  for (int i = 1; i < argc; i++) {
+    if (std::string("--stats") != argv[i]) { continue; }
+#ifdef XSG_STATS
+    std::cerr << std::endl << "Statistics:" << std::endl << gen1.stats();
+#else
+    std::cerr << std::endl << "Statistics not collected (build with XSG_STATS defined, eg. `make stats=1')" << std::endl;
+#endif
+    break;
   }
 
-
-  return 0;}
+  return 0;
+}
 